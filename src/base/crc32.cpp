@@ -0,0 +1,30 @@
+#include "crc32.h"
+
+namespace base {
+
+struct Crc32Table {
+    uint32_t values[256];
+
+    constexpr Crc32Table() : values() {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t value = i;
+            for (int bit = 0; bit < 8; bit++) {
+                value = (value & 1) ? (value >> 1) ^ 0xEDB88320u : value >> 1;
+            }
+            values[i] = value;
+        }
+    }
+};
+
+static constexpr Crc32Table kCrc32Table;
+
+uint32_t crc32(const void *data, size_t size, uint32_t crc) {
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) {
+        crc = kCrc32Table.values[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+}  // namespace base
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace base {
+
+/**
+ * @brief CRC-32 (IEEE 802.3), pass the previous result as crc to continue a checksum
+ */
+uint32_t crc32(const void *data, size_t size, uint32_t crc = 0);
+
+}  // namespace base
@@ -1,7 +1,9 @@
 #include "file_operation.h"
 
+#include <fcntl.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <unistd.h>
 
 #include <cerrno>
 #include <cstring>
@@ -29,4 +31,50 @@ bool create_folder_if_not_exit(std::string foler_path) {
     return false;
 }
 
+bool write_file_atomic(const std::string &path, const std::string &content) {
+    std::string temp_path = path + ".tmp";
+    int fd = open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        LogError() << "Failed to open " << temp_path << " : " << std::strerror(errno);
+        return false;
+    }
+    const char *data = content.data();
+    size_t remain = content.size();
+    while (remain > 0) {
+        ssize_t written = write(fd, data, remain);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LogError() << "Failed to write " << temp_path << " : " << std::strerror(errno);
+            close(fd);
+            unlink(temp_path.c_str());
+            return false;
+        }
+        data += written;
+        remain -= written;
+    }
+    if (fsync(fd) != 0) {
+        LogError() << "Failed to sync " << temp_path << " : " << std::strerror(errno);
+        close(fd);
+        unlink(temp_path.c_str());
+        return false;
+    }
+    close(fd);
+
+    if (rename(temp_path.c_str(), path.c_str()) != 0) {
+        LogError() << "Failed to rename " << temp_path << " : " << std::strerror(errno);
+        unlink(temp_path.c_str());
+        return false;
+    }
+    // persist the rename itself
+    std::string folder_path = path.substr(0, path.find_last_of('/') + 1);
+    int folder_fd = open(folder_path.empty() ? "." : folder_path.c_str(), O_RDONLY | O_DIRECTORY);
+    if (folder_fd >= 0) {
+        fsync(folder_fd);
+        close(folder_fd);
+    }
+    return true;
+}
+
 }  // namespace base
\ No newline at end of file
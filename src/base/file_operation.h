@@ -4,4 +4,11 @@
 
 namespace base {
 bool create_folder_if_not_exit(std::string foler_path);
+
+/**
+ * @brief replace file content atomically
+ * @details write a temp file next to path, fsync it and rename it over path, so a power cut
+ * leaves either the old or the new content
+ */
+bool write_file_atomic(const std::string &path, const std::string &content);
 }
\ No newline at end of file
@@ -0,0 +1,195 @@
+#include "heartbeat.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "log.h"
+
+namespace base {
+
+std::string heartbeat_path(const std::string &process) {
+    return "/dev/shm/mavcam_" + process + ".heartbeat";
+}
+
+Heartbeat &Heartbeat::instance() {
+    static Heartbeat heartbeat;
+    return heartbeat;
+}
+
+Heartbeat::~Heartbeat() {
+    // threads may still beat while statics are destroyed, so the region stays mapped
+}
+
+bool Heartbeat::open(const std::string &process) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_region.load() != nullptr) {
+        return true;
+    }
+    std::string path = heartbeat_path(process);
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        LogWarn() << "Cannot open heartbeat " << path << ": " << strerror(errno);
+        return false;
+    }
+    // truncate first, so a region left by an older process reads as zeros
+    void *memory = MAP_FAILED;
+    if (ftruncate(fd, 0) == 0 && ftruncate(fd, sizeof(HeartbeatRegion)) == 0) {
+        memory = mmap(nullptr, sizeof(HeartbeatRegion), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (memory == MAP_FAILED) {
+        LogWarn() << "Cannot map heartbeat " << path << ": " << strerror(errno);
+        return false;
+    }
+    auto *region = static_cast<HeartbeatRegion *>(memory);
+    region->pid.store(static_cast<uint32_t>(getpid()), std::memory_order_relaxed);
+    region->magic.store(kHeartbeatMagic, std::memory_order_release);
+    _region.store(region, std::memory_order_release);
+    LogInfo() << "Heartbeat at " << path;
+    return true;
+}
+
+/**
+ * @brief slots of one thread, released when the thread exits, e.g. a retired grpc handler thread
+ */
+struct ThreadSlots {
+    ~ThreadSlots() {
+        for (const auto &slot : slots) {
+            slot.second->used.store(0, std::memory_order_release);
+        }
+    }
+    // a thread only uses a few names, name must outlive the thread
+    std::vector<std::pair<const char *, HeartbeatSlot *>> slots{};
+};
+
+HeartbeatSlot *Heartbeat::thread_slot(const char *name) {
+    HeartbeatRegion *region = _region.load(std::memory_order_acquire);
+    if (region == nullptr) {
+        return nullptr;
+    }
+    thread_local ThreadSlots thread_slots;
+    for (const auto &slot : thread_slots.slots) {
+        if (slot.first == name || strcmp(slot.first, name) == 0) {
+            return slot.second;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    // a slot released by an exited thread first
+    uint32_t count = region->slot_count.load(std::memory_order_relaxed);
+    uint32_t index = 0;
+    while (index < count && region->slots[index].used.load(std::memory_order_acquire) != 0) {
+        index++;
+    }
+    if (index >= kHeartbeatSlots) {
+        if (!_full_reported) {
+            _full_reported = true;
+            LogWarn() << "All " << kHeartbeatSlots << " heartbeat slots are taken, " << name
+                      << " is not watched";
+        }
+        return nullptr;
+    }
+    HeartbeatSlot *slot = &region->slots[index];
+    std::string slot_name = std::string(name) + "/" + std::to_string(syscall(SYS_gettid));
+    memset(slot->name, 0, kHeartbeatNameSize);
+    strncpy(slot->name, slot_name.c_str(), kHeartbeatNameSize - 1);
+    // even count, the new thread starts idle
+    slot->beats.store(0, std::memory_order_relaxed);
+    slot->used.store(1, std::memory_order_release);
+    if (index == count) {
+        region->slot_count.store(index + 1, std::memory_order_release);
+    }
+    thread_slots.slots.emplace_back(name, slot);
+    return slot;
+}
+
+HeartbeatScope::HeartbeatScope(const char *name) : _slot(Heartbeat::instance().thread_slot(name)) {
+    if (_slot != nullptr) {
+        _slot->beats.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+HeartbeatScope::~HeartbeatScope() {
+    if (_slot != nullptr) {
+        _slot->beats.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+HeartbeatReader::~HeartbeatReader() {
+    close();
+}
+
+bool HeartbeatReader::open(const std::string &process, pid_t pid) {
+    close();
+    int fd = ::open(heartbeat_path(process).c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    void *memory = MAP_FAILED;
+    struct stat info;
+    if (fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= sizeof(HeartbeatRegion)) {
+        memory = mmap(nullptr, sizeof(HeartbeatRegion), PROT_READ, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (memory == MAP_FAILED) {
+        return false;
+    }
+    auto *region = static_cast<const HeartbeatRegion *>(memory);
+    if (region->magic.load(std::memory_order_acquire) != kHeartbeatMagic ||
+        region->pid.load(std::memory_order_relaxed) != static_cast<uint32_t>(pid)) {
+        munmap(memory, sizeof(HeartbeatRegion));
+        return false;
+    }
+    _region = region;
+    auto now = std::chrono::steady_clock::now();
+    for (auto &track : _tracks) {
+        track = Track{0, now, false};
+    }
+    return true;
+}
+
+void HeartbeatReader::close() {
+    if (_region != nullptr) {
+        munmap(const_cast<HeartbeatRegion *>(_region), sizeof(HeartbeatRegion));
+        _region = nullptr;
+    }
+}
+
+std::vector<HeartbeatReader::Stall> HeartbeatReader::check(
+    std::chrono::steady_clock::duration threshold) {
+    std::vector<Stall> stalls;
+    if (_region == nullptr) {
+        return stalls;
+    }
+    auto now = std::chrono::steady_clock::now();
+    uint32_t count = std::min<uint32_t>(_region->slot_count.load(std::memory_order_acquire),
+                                        kHeartbeatSlots);
+    for (uint32_t i = 0; i < count; i++) {
+        const HeartbeatSlot &slot = _region->slots[i];
+        if (slot.used.load(std::memory_order_acquire) == 0) {
+            continue;
+        }
+        Track &track = _tracks[i];
+        uint32_t beats = slot.beats.load(std::memory_order_relaxed);
+        if (beats != track.beats) {
+            track = Track{beats, now, false};
+            continue;
+        }
+        bool busy = (beats & 1) != 0;
+        if (busy && !track.reported && now - track.changed >= threshold) {
+            track.reported = true;
+            stalls.push_back(Stall{std::string(slot.name, strnlen(slot.name, kHeartbeatNameSize)),
+                                   now - track.changed});
+        }
+    }
+    return stalls;
+}
+
+}  // namespace base
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace base {
+
+constexpr uint32_t kHeartbeatMagic = 0x4d434842;  // "MCHB"
+constexpr size_t kHeartbeatSlots = 32;
+constexpr size_t kHeartbeatNameSize = 32;
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free,
+              "heartbeat counters are shared between processes");
+
+/**
+ * @brief Counter of one thread in the heartbeat region
+ * @details beats is bumped when the thread starts and when it ends a piece of work, so an odd
+ * value means the thread is busy. A busy thread whose beats stop moving is stalled, an idle
+ * thread waiting for work is not.
+ */
+struct HeartbeatSlot {
+    std::atomic<uint32_t> beats;
+    std::atomic<uint32_t> used;  ///< set once name is written, cleared when the thread exits
+    char name[kHeartbeatNameSize];
+};
+
+/**
+ * @brief Layout of the shared memory file, it only holds atomics and plain chars
+ */
+struct HeartbeatRegion {
+    std::atomic<uint32_t> magic;  ///< written last, region is valid once set
+    std::atomic<uint32_t> pid;    ///< process owning the region
+    std::atomic<uint32_t> slot_count;  ///< slots ever used, unused ones among them are reused
+    HeartbeatSlot slots[kHeartbeatSlots];
+};
+
+/**
+ * @brief heartbeat file of a process, lives in /dev/shm
+ */
+std::string heartbeat_path(const std::string &process);
+
+/**
+ * @brief Writer side of the heartbeat, beating costs one atomic add and no syscall
+ */
+class Heartbeat final {
+public:
+    static Heartbeat &instance();
+    ~Heartbeat();
+public:
+    /**
+     * @brief create the region of this process, beats before open are not recorded
+     */
+    bool open(const std::string &process);
+    /**
+     * @brief slot of the calling thread for name, registered on first use, released when the
+     * thread exits
+     * @return nullptr when heartbeat is not open or all slots are taken
+     */
+    HeartbeatSlot *thread_slot(const char *name);
+private:
+    Heartbeat() = default;
+private:
+    std::mutex _mutex{};
+    std::atomic<HeartbeatRegion *> _region{nullptr};
+    bool _full_reported{false};
+};
+
+/**
+ * @brief Marks the enclosing scope as busy work of the calling thread
+ * @details scopes of the same name must not nest on one thread
+ */
+class HeartbeatScope final {
+public:
+    explicit HeartbeatScope(const char *name);
+    ~HeartbeatScope();
+    HeartbeatScope(const HeartbeatScope &) = delete;
+    HeartbeatScope &operator=(const HeartbeatScope &) = delete;
+private:
+    HeartbeatSlot *_slot;
+};
+
+/**
+ * @brief Reader side of the heartbeat, used by the supervisor
+ */
+class HeartbeatReader final {
+public:
+    struct Stall {
+        std::string name{};
+        std::chrono::steady_clock::duration duration{};
+    };
+public:
+    ~HeartbeatReader();
+public:
+    /**
+     * @brief map the region of process
+     * @return false while the region is missing or still belongs to an older pid
+     */
+    bool open(const std::string &process, pid_t pid);
+    void close();
+    bool is_open() const { return _region != nullptr; }
+    /**
+     * @brief sample all slots
+     * @return threads busy without progress for threshold, each stall is reported once
+     */
+    std::vector<Stall> check(std::chrono::steady_clock::duration threshold);
+private:
+    struct Track {
+        uint32_t beats{0};
+        std::chrono::steady_clock::time_point changed{};
+        bool reported{false};
+    };
+private:
+    const HeartbeatRegion *_region{nullptr};
+    Track _tracks[kHeartbeatSlots]{};
+};
+
+}  // namespace base
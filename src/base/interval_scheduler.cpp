@@ -0,0 +1,160 @@
+#include "interval_scheduler.h"
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "heartbeat.h"
+#include "log.h"
+
+namespace base {
+
+static constexpr int64_t kNanosPerSecond = 1000000000;
+
+static int64_t to_nanos(const struct timespec &time) {
+    return static_cast<int64_t>(time.tv_sec) * kNanosPerSecond + time.tv_nsec;
+}
+
+static struct timespec to_timespec(int64_t nanos) {
+    struct timespec time;
+    time.tv_sec = static_cast<time_t>(nanos / kNanosPerSecond);
+    time.tv_nsec = static_cast<long>(nanos % kNanosPerSecond);
+    return time;
+}
+
+IntervalScheduler::~IntervalScheduler() {
+    stop();
+}
+
+bool IntervalScheduler::start(std::chrono::nanoseconds interval, uint32_t count, Task task) {
+    std::lock_guard<std::mutex> lock(_control_mutex);
+    if (running()) {
+        return false;
+    }
+    // a run that ended by its count still has to be joined
+    join_locked();
+    if (interval.count() <= 0) {
+        return false;
+    }
+    _timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    _stop_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    // the first deadline is now, so the first run does not wait for a whole interval
+    struct itimerspec timer;
+    timer.it_value = now;
+    timer.it_interval = to_timespec(interval.count());
+    if (_timer_fd < 0 || _stop_fd < 0 ||
+        timerfd_settime(_timer_fd, TFD_TIMER_ABSTIME, &timer, nullptr) != 0) {
+        LogError() << "Cannot create interval timer: " << strerror(errno);
+        join_locked();
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> statistics_lock(_mutex);
+        _statistics = Statistics{};
+        _jitter_sum_ms = 0.0;
+    }
+    _first_deadline = to_nanos(now);
+    _interval = interval;
+    _count = count;
+    _task = std::move(task);
+    _running.store(true, std::memory_order_release);
+    _work_thread = new std::thread(work_thread, this);
+    return true;
+}
+
+void IntervalScheduler::stop() {
+    std::lock_guard<std::mutex> lock(_control_mutex);
+    if (_stop_fd >= 0) {
+        uint64_t value = 1;
+        if (write(_stop_fd, &value, sizeof(value)) != sizeof(value)) {
+            LogWarn() << "Cannot wake interval thread: " << strerror(errno);
+        }
+    }
+    join_locked();
+}
+
+IntervalScheduler::Statistics IntervalScheduler::statistics() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _statistics;
+}
+
+void IntervalScheduler::join_locked() {
+    if (_work_thread != nullptr) {
+        _work_thread->join();
+        delete _work_thread;
+        _work_thread = nullptr;
+    }
+    if (_timer_fd >= 0) {
+        close(_timer_fd);
+        _timer_fd = -1;
+    }
+    if (_stop_fd >= 0) {
+        close(_stop_fd);
+        _stop_fd = -1;
+    }
+    _task = nullptr;
+    _running.store(false, std::memory_order_release);
+}
+
+void IntervalScheduler::work_thread(IntervalScheduler *self) {
+    struct timespec now;
+    uint64_t deadlines = 0;
+    struct pollfd fds[2] = {{self->_timer_fd, POLLIN, 0}, {self->_stop_fd, POLLIN, 0}};
+    while (true) {
+        int ret = poll(fds, 2, -1);
+        if (ret < 0 && errno != EINTR) {
+            LogError() << "Interval poll failed: " << strerror(errno);
+            break;
+        }
+        if (ret <= 0) {
+            continue;
+        }
+        if ((fds[1].revents & POLLIN) != 0) {
+            break;
+        }
+        uint64_t expirations = 0;
+        if (read(self->_timer_fd, &expirations, sizeof(expirations)) != sizeof(expirations) ||
+            expirations == 0) {
+            continue;
+        }
+        deadlines += expirations;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        int64_t deadline =
+            self->_first_deadline + static_cast<int64_t>(deadlines - 1) * self->_interval.count();
+        float jitter_ms = std::max<int64_t>(to_nanos(now) - deadline, 0) / 1e6f;
+        bool success = false;
+        {
+            HeartbeatScope heartbeat("interval_task");
+            success = self->_task();
+        }
+        std::lock_guard<std::mutex> lock(self->_mutex);
+        Statistics &statistics = self->_statistics;
+        if (success) {
+            statistics.triggers++;
+        } else {
+            statistics.failed++;
+        }
+        uint32_t runs = statistics.triggers + statistics.failed;
+        statistics.missed += static_cast<uint32_t>(expirations - 1);
+        self->_jitter_sum_ms += static_cast<double>(jitter_ms);
+        statistics.mean_jitter_ms = static_cast<float>(self->_jitter_sum_ms / runs);
+        statistics.max_jitter_ms = std::max(statistics.max_jitter_ms, jitter_ms);
+        if (expirations > 1) {
+            LogWarn() << "Interval task skipped " << expirations - 1 << " deadlines";
+        }
+        if (self->_count != 0 && runs >= self->_count) {
+            break;
+        }
+    }
+    self->_running.store(false, std::memory_order_release);
+}
+
+}  // namespace base
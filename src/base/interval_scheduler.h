@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace base {
+
+/**
+ * @brief Runs a task periodically on absolute deadlines
+ * @details Deadlines are start + n * interval on the monotonic clock and are kept by a timerfd, so
+ * a late run does not shift the ones after it. Deadlines passed while the task still runs are
+ * skipped and counted as missed, they are never queued up. The first run happens at start. The
+ * task returns false when its run failed, such runs are counted apart from the others.
+ */
+class IntervalScheduler final {
+public:
+    using Task = std::function<bool()>;
+    struct Statistics {
+        uint32_t triggers{0};        ///< runs of the task that succeeded
+        uint32_t failed{0};          ///< runs of the task that failed
+        uint32_t missed{0};          ///< deadlines skipped while the task was still running
+        float mean_jitter_ms{0.0f};  ///< mean delay of a run behind its deadline
+        float max_jitter_ms{0.0f};
+    };
+public:
+    IntervalScheduler() = default;
+    ~IntervalScheduler();
+    IntervalScheduler(const IntervalScheduler &) = delete;
+    IntervalScheduler &operator=(const IntervalScheduler &) = delete;
+public:
+    /**
+     * @param count runs, failed ones included, before the scheduler stops by itself, 0 to run
+     * until stop()
+     * @return false when interval is not positive, already running or timer cannot be created
+     */
+    bool start(std::chrono::nanoseconds interval, uint32_t count, Task task);
+    /**
+     * @brief stop and wait for a running task, must not be called from the task
+     */
+    void stop();
+    bool running() const { return _running.load(std::memory_order_acquire); }
+    /**
+     * @brief statistics of the current or the last run
+     */
+    Statistics statistics() const;
+private:
+    static void work_thread(IntervalScheduler *self);
+    void join_locked();
+private:
+    std::mutex _control_mutex{};  ///< serializes start() and stop()
+    std::thread *_work_thread{nullptr};
+    int _timer_fd{-1};
+    int _stop_fd{-1};
+    int64_t _first_deadline{0};  ///< ns of the monotonic clock
+    std::chrono::nanoseconds _interval{0};
+    uint32_t _count{0};
+    Task _task{};
+    std::atomic<bool> _running{false};
+    mutable std::mutex _mutex{};  ///< guards the statistics
+    Statistics _statistics{};
+    double _jitter_sum_ms{0.0};
+};
+
+}  // namespace base
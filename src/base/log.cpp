@@ -1,5 +1,8 @@
 #include "log.h"
 
+#include <atomic>
+#include <chrono>
+
 #if defined(WINDOWS)
 #include <windows.h>
 #define WIN_COLOR_RED 4
@@ -20,6 +23,9 @@
 namespace base {
 
 static log::Callback callback_{nullptr};
+static std::atomic<int> min_level_{static_cast<int>(log::Level::Debug)};
+static log::BinaryCallback binary_callback_{nullptr};
+static std::atomic<uint32_t> next_site_id_{1};
 
 log::Callback &log::get_callback() {
     return callback_;
@@ -29,6 +35,178 @@ void log::subscribe(const log::Callback &callback) {
     callback_ = callback;
 }
 
+void log::set_min_level(log::Level level) {
+    min_level_.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+log::Level log::get_min_level() {
+    return static_cast<log::Level>(min_level_.load(std::memory_order_relaxed));
+}
+
+log::BinaryCallback &log::get_binary_callback() {
+    return binary_callback_;
+}
+
+void log::subscribe_binary(const log::BinaryCallback &callback) {
+    binary_callback_ = callback;
+}
+
+void LogDetailed::write_repeated() {
+    static thread_local std::string notice;
+    notice.assign(std::to_string(_repeated));
+    notice.append(" messages suppressed at ");
+    notice.append(_caller_filename);
+    notice.append(":");
+    notice.append(std::to_string(_caller_filenumber));
+    write_text(notice);
+}
+
+void LogDetailed::write_text(const std::string &message) {
+    if (log::get_callback() &&
+        log::get_callback()(_log_level, message, _caller_filename, _caller_filenumber)) {
+        return;
+    }
+
+#if ANDROID
+    switch (_log_level) {
+        case log::Level::Debug:
+            __android_log_print(ANDROID_LOG_DEBUG, "MAVCam", "%s", message.c_str());
+            break;
+        case log::Level::Info:
+            __android_log_print(ANDROID_LOG_INFO, "MAVCam", "%s", message.c_str());
+            break;
+        case log::Level::Warn:
+            __android_log_print(ANDROID_LOG_WARN, "MAVCam", "%s", message.c_str());
+            break;
+        case log::Level::Err:
+            __android_log_print(ANDROID_LOG_ERROR, "MAVCam", "%s", message.c_str());
+            break;
+    }
+    // Unused:
+    (void)_caller_filename;
+    (void)_caller_filenumber;
+#else
+
+    switch (_log_level) {
+        case log::Level::Debug:
+            set_color(Color::Green);
+            break;
+        case log::Level::Info:
+            set_color(Color::Blue);
+            break;
+        case log::Level::Warn:
+            set_color(Color::Yellow);
+            break;
+        case log::Level::Err:
+            set_color(Color::Red);
+            break;
+    }
+
+    // Time output taken from:
+    // https://stackoverflow.com/questions/16357999#answer-16358264
+    time_t rawtime;
+    time(&rawtime);
+    struct tm *timeinfo = localtime(&rawtime);
+    char time_buffer[10]{};  // We need 8 characters + \0
+    strftime(time_buffer, sizeof(time_buffer), "%I:%M:%S", timeinfo);
+    std::cout << "[" << time_buffer;
+
+    switch (_log_level) {
+        case log::Level::Debug:
+            std::cout << "|Debug] ";
+            break;
+        case log::Level::Info:
+            std::cout << "|Info ] ";
+            break;
+        case log::Level::Warn:
+            std::cout << "|Warn ] ";
+            break;
+        case log::Level::Err:
+            std::cout << "|Error] ";
+            break;
+    }
+
+    set_color(Color::Reset);
+
+    std::cout << message;
+    std::cout << " (" << _caller_filename << ":" << std::dec << _caller_filenumber << ")";
+
+    std::cout << '\n';
+#endif
+}
+
+void LogDetailed::append_literal(std::string_view literal) {
+    if (!_build_format) {
+        return;
+    }
+    for (char c : literal) {
+        _format.push_back(c);
+        if (c == '{' || c == '}') {
+            _format.push_back(c);
+        }
+    }
+}
+
+void LogDetailed::append_arg(log::binary::ArgType type) {
+    if (_build_format) {
+        _format.append("{}");
+    }
+    log::binary::put(_buffer, static_cast<uint8_t>(type));
+}
+
+void LogDetailed::write_binary() {
+    auto &callback = log::get_binary_callback();
+    if (!callback) {
+        return;
+    }
+
+    uint32_t id = _site->id.load(std::memory_order_acquire);
+    if (id == 0) {
+        uint32_t new_id = next_site_id_.fetch_add(1, std::memory_order_relaxed);
+        if (_site->id.compare_exchange_strong(id, new_id, std::memory_order_acq_rel)) {
+            id = new_id;
+        }
+    }
+
+    // reuse the capacity of a per thread string, no allocation after warm up
+    static thread_local std::string record;
+    if (_build_format && !_site->defined.exchange(true, std::memory_order_acq_rel)) {
+        record.clear();
+        size_t offset = log::binary::begin_record(record, log::binary::RecordType::SiteDefinition);
+        log::binary::put(record, id);
+        log::binary::put(record, static_cast<uint8_t>(_log_level));
+        log::binary::put(record, static_cast<uint32_t>(_caller_filenumber));
+        log::binary::put_string(record, _caller_filename);
+        log::binary::put_string(record, _format);
+        if (log::binary::end_record(record, offset)) {
+            callback(record.data(), record.size());
+        }
+    }
+
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    uint64_t time_us = std::chrono::duration_cast<std::chrono::microseconds>(now).count();
+    if (_repeated > 0) {
+        record.clear();
+        size_t offset = log::binary::begin_record(record, log::binary::RecordType::Repeated);
+        log::binary::put(record, id);
+        log::binary::put(record, time_us);
+        log::binary::put(record, _repeated);
+        if (log::binary::end_record(record, offset)) {
+            callback(record.data(), record.size());
+        }
+    }
+
+    record.clear();
+    size_t offset = log::binary::begin_record(record, log::binary::RecordType::Message);
+    log::binary::put(record, id);
+    log::binary::put(record, time_us);
+    std::string_view arguments = _buffer.view();
+    record.append(arguments.data(), arguments.size());
+    if (log::binary::end_record(record, offset)) {
+        callback(record.data(), record.size());
+    }
+}
+
 void set_color(Color color) {
 #if defined(WINDOWS)
     HANDLE handle = GetStdHandle(STD_OUTPUT_HANDLE);
@@ -1,8 +1,19 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
 #include <sstream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 
+#include "log_binary.h"
 #include "log_callback.h"
+#include "log_rate_limiter.h"
 
 #if defined(ANDROID)
 #include <android/log.h>
@@ -19,14 +30,51 @@
 #define FILENAME __FILE__
 #endif
 
+// First token of the LogX() macros. Callers write base::LogX() or LogX(), so it is declared at
+// global scope and in base, everything after it in the expansion is fully qualified.
+inline constexpr bool base_log_gate = true;
+
 namespace base {
 
+using ::base_log_gate;
+
 #define call_user_callback(...) call_user_callback_located(FILENAME, __LINE__, __VA_ARGS__)
 
-#define LogDebug() LogDebugDetailed(FILENAME, __LINE__)
-#define LogInfo() LogInfoDetailed(FILENAME, __LINE__)
-#define LogWarn() LogWarnDetailed(FILENAME, __LINE__)
-#define LogError() LogErrDetailed(FILENAME, __LINE__)
+// Every call site owns a static LogSite, binary log refers the site by its id.
+#define LOG_SITE()                        \
+    [] {                                  \
+        static ::base::LogSite log_site;  \
+        return &log_site;                 \
+    }()
+
+// The level check runs before the message object is built, so messages below the minimum
+// level cost one atomic load. Build with DISABLE_DEBUG_LOG to remove LogDebug() completely.
+#if defined(DISABLE_DEBUG_LOG)
+#define LogDebug()                                    \
+    base_log_gate && ::base::log_compiled_out() &&    \
+        ::base::LogDebugDetailed(FILENAME, __LINE__, LOG_SITE())
+#else
+#define LogDebug()                                                      \
+    base_log_gate && ::base::log_enabled(::base::log::Level::Debug) && \
+        ::base::LogDebugDetailed(FILENAME, __LINE__, LOG_SITE())
+#endif
+#define LogInfo()                                                      \
+    base_log_gate && ::base::log_enabled(::base::log::Level::Info) && \
+        ::base::LogInfoDetailed(FILENAME, __LINE__, LOG_SITE())
+#define LogWarn()                                                      \
+    base_log_gate && ::base::log_enabled(::base::log::Level::Warn) && \
+        ::base::LogWarnDetailed(FILENAME, __LINE__, LOG_SITE())
+#define LogError()                                                    \
+    base_log_gate && ::base::log_enabled(::base::log::Level::Err) && \
+        ::base::LogErrDetailed(FILENAME, __LINE__, LOG_SITE())
+
+inline bool log_enabled(log::Level level) {
+    return static_cast<int>(level) >= static_cast<int>(log::get_min_level());
+}
+
+constexpr bool log_compiled_out() {
+    return false;
+}
 
 enum class Color {
     Red,
@@ -39,89 +87,119 @@ enum class Color {
 
 void set_color(Color color);
 
+/**
+ * @brief stream buffer for one log message
+ * @details keep the message in a fixed-capacity buffer on the stack, only long messages
+ * spill to the heap
+ */
+class LogBuffer : public std::streambuf {
+public:
+    static constexpr size_t kCapacity = 512;
+public:
+    LogBuffer() { setp(_buffer, _buffer + kCapacity); }
+
+    void append(const char *data, size_t size) {
+        sputn(data, static_cast<std::streamsize>(size));
+    }
+
+    std::string_view view() const {
+        if (_spilled) {
+            return std::string_view(_spill);
+        }
+        return std::string_view(pbase(), pptr() - pbase());
+    }
+protected:
+    int_type overflow(int_type ch) override {
+        if (traits_type::eq_int_type(ch, traits_type::eof())) {
+            return traits_type::not_eof(ch);
+        }
+        spill();
+        _spill.push_back(traits_type::to_char_type(ch));
+        return ch;
+    }
+
+    std::streamsize xsputn(const char *s, std::streamsize n) override {
+        if (!_spilled && epptr() - pptr() >= n) {
+            memcpy(pptr(), s, n);
+            pbump(static_cast<int>(n));
+            return n;
+        }
+        spill();
+        _spill.append(s, n);
+        return n;
+    }
+private:
+    void spill() {
+        if (!_spilled) {
+            _spill.assign(pbase(), pptr() - pbase());
+            setp(nullptr, nullptr);
+            _spilled = true;
+        }
+    }
+private:
+    char _buffer[kCapacity];
+    bool _spilled{false};
+    std::string _spill{};
+};
+
+/**
+ * @brief static state of one log call site
+ * @details id is assigned on first binary message, the site definition (file, line and format)
+ * is written to binary log only once. The rate limiter keeps its bucket here too.
+ */
+struct LogSite {
+    std::atomic<uint32_t> id{0};
+    std::atomic<bool> defined{false};
+    LogRateLimiter::State rate_state{};
+};
+
 class LogDetailed {
 public:
-    LogDetailed(const char *filename, int filenumber)
-        : _s(), _caller_filename(filename), _caller_filenumber(filenumber) {}
+    LogDetailed(const char *filename, int filenumber, LogSite *site = nullptr,
+                log::Level level = log::Level::Debug)
+        : _log_level(level),
+          _buffer(),
+          _s(&_buffer),
+          _caller_filename(filename),
+          _caller_filenumber(filenumber),
+          _site(site),
+          _suppressed(site != nullptr &&
+                      !log::get_rate_limiter().allow(
+                          level, site->rate_state, _repeated,
+                          {filename, filenumber, site->id.load(std::memory_order_relaxed)})),
+          _binary(site != nullptr && log::get_binary_callback() != nullptr),
+          _build_format(_binary && !site->defined.load(std::memory_order_acquire)) {}
+
+    explicit operator bool() const { return true; }
 
     template <typename T>
-    LogDetailed &operator<<(const T &x) {
-        _s << x;
+    LogDetailed &operator<<(T &&x) {
+        if (_suppressed) {
+            // drop the message without formatting
+        } else if (_binary) {
+            append_binary(std::forward<T>(x));
+        } else {
+            _s << x;
+        }
         return *this;
     }
 
     virtual ~LogDetailed() {
-        if (log::get_callback() &&
-            log::get_callback()(_log_level, _s.str(), _caller_filename, _caller_filenumber)) {
+        if (_suppressed) {
             return;
         }
-
-#if ANDROID
-        switch (_log_level) {
-            case log::Level::Debug:
-                __android_log_print(ANDROID_LOG_DEBUG, "MAVCam", "%s", _s.str().c_str());
-                break;
-            case log::Level::Info:
-                __android_log_print(ANDROID_LOG_INFO, "MAVCam", "%s", _s.str().c_str());
-                break;
-            case log::Level::Warn:
-                __android_log_print(ANDROID_LOG_WARN, "MAVCam", "%s", _s.str().c_str());
-                break;
-            case log::Level::Err:
-                __android_log_print(ANDROID_LOG_ERROR, "MAVCam", "%s", _s.str().c_str());
-                break;
-        }
-        // Unused:
-        (void)_caller_filename;
-        (void)_caller_filenumber;
-#else
-
-        switch (_log_level) {
-            case log::Level::Debug:
-                set_color(Color::Green);
-                break;
-            case log::Level::Info:
-                set_color(Color::Blue);
-                break;
-            case log::Level::Warn:
-                set_color(Color::Yellow);
-                break;
-            case log::Level::Err:
-                set_color(Color::Red);
-                break;
+        if (_binary) {
+            write_binary();
+            return;
         }
-
-        // Time output taken from:
-        // https://stackoverflow.com/questions/16357999#answer-16358264
-        time_t rawtime;
-        time(&rawtime);
-        struct tm *timeinfo = localtime(&rawtime);
-        char time_buffer[10]{};  // We need 8 characters + \0
-        strftime(time_buffer, sizeof(time_buffer), "%I:%M:%S", timeinfo);
-        std::cout << "[" << time_buffer;
-
-        switch (_log_level) {
-            case log::Level::Debug:
-                std::cout << "|Debug] ";
-                break;
-            case log::Level::Info:
-                std::cout << "|Info ] ";
-                break;
-            case log::Level::Warn:
-                std::cout << "|Warn ] ";
-                break;
-            case log::Level::Err:
-                std::cout << "|Error] ";
-                break;
+        if (_repeated > 0) {
+            write_repeated();
         }
 
-        set_color(Color::Reset);
-
-        std::cout << _s.str();
-        std::cout << " (" << _caller_filename << ":" << std::dec << _caller_filenumber << ")";
-
-        std::cout << '\n';
-#endif
+        // reuse the capacity of a per thread string, callback api needs std::string
+        static thread_local std::string message;
+        message.assign(_buffer.view());
+        write_text(message);
     }
 
     LogDetailed(const base::LogDetailed &) = delete;
@@ -129,37 +207,89 @@ public:
 protected:
     log::Level _log_level = log::Level::Debug;
 private:
-    std::stringstream _s;
+    template <typename T>
+    void append_binary(T &&x) {
+        using Value = std::remove_reference_t<T>;
+        using Type = std::remove_cv_t<Value>;
+        if constexpr (std::is_array_v<Value> && std::is_const_v<Value> &&
+                      std::is_same_v<std::remove_cv_t<std::remove_extent_t<Value>>, char>) {
+            // const char array is a string literal, it goes to the site format only
+            append_literal(std::string_view(x, strnlen(x, std::extent_v<Value>)));
+            return;
+        } else if constexpr (std::is_same_v<Type, bool>) {
+            append_arg(log::binary::ArgType::Bool);
+            log::binary::put(_buffer, static_cast<uint8_t>(x));
+        } else if constexpr (std::is_same_v<Type, char> || std::is_same_v<Type, signed char> ||
+                             std::is_same_v<Type, unsigned char>) {
+            append_arg(log::binary::ArgType::Char);
+            log::binary::put(_buffer, static_cast<char>(x));
+        } else if constexpr (std::is_integral_v<Type> && std::is_signed_v<Type>) {
+            append_arg(log::binary::ArgType::Int);
+            log::binary::put_zigzag(_buffer, static_cast<int64_t>(x));
+        } else if constexpr (std::is_integral_v<Type> || std::is_enum_v<Type>) {
+            append_arg(log::binary::ArgType::UInt);
+            log::binary::put_varint(_buffer, static_cast<uint64_t>(x));
+        } else if constexpr (std::is_floating_point_v<Type>) {
+            append_arg(log::binary::ArgType::Double);
+            log::binary::put(_buffer, static_cast<double>(x));
+        } else if constexpr (std::is_same_v<std::decay_t<Type>, const char *> ||
+                             std::is_same_v<std::decay_t<Type>, char *>) {
+            append_arg(log::binary::ArgType::String);
+            log::binary::put_string(_buffer, x != nullptr ? std::string_view(x) : "(null)");
+        } else if constexpr (std::is_convertible_v<const Type &, std::string_view>) {
+            append_arg(log::binary::ArgType::String);
+            log::binary::put_string(_buffer, std::string_view(x));
+        } else {
+            // other types keep their operator<< output as string
+            LogBuffer text;
+            std::ostream stream(&text);
+            stream << x;
+            append_arg(log::binary::ArgType::String);
+            log::binary::put_string(_buffer, text.view());
+        }
+    }
+
+    void append_literal(std::string_view literal);
+    void append_arg(log::binary::ArgType type);
+    void write_binary();
+    void write_repeated();
+    void write_text(const std::string &message);
+private:
+    LogBuffer _buffer;
+    std::ostream _s;
     const char *_caller_filename;
     int _caller_filenumber;
+private:  // binary log
+    LogSite *_site;
+    uint32_t _repeated{0};
+    bool _suppressed;
+    bool _binary;
+    bool _build_format;
+    std::string _format{};
 };
 
 class LogDebugDetailed : public LogDetailed {
 public:
-    LogDebugDetailed(const char *filename, int filenumber) : LogDetailed(filename, filenumber) {
-        _log_level = log::Level::Debug;
-    }
+    LogDebugDetailed(const char *filename, int filenumber, LogSite *site = nullptr)
+        : LogDetailed(filename, filenumber, site, log::Level::Debug) {}
 };
 
 class LogInfoDetailed : public LogDetailed {
 public:
-    LogInfoDetailed(const char *filename, int filenumber) : LogDetailed(filename, filenumber) {
-        _log_level = log::Level::Info;
-    }
+    LogInfoDetailed(const char *filename, int filenumber, LogSite *site = nullptr)
+        : LogDetailed(filename, filenumber, site, log::Level::Info) {}
 };
 
 class LogWarnDetailed : public LogDetailed {
 public:
-    LogWarnDetailed(const char *filename, int filenumber) : LogDetailed(filename, filenumber) {
-        _log_level = log::Level::Warn;
-    }
+    LogWarnDetailed(const char *filename, int filenumber, LogSite *site = nullptr)
+        : LogDetailed(filename, filenumber, site, log::Level::Warn) {}
 };
 
 class LogErrDetailed : public LogDetailed {
 public:
-    LogErrDetailed(const char *filename, int filenumber) : LogDetailed(filename, filenumber) {
-        _log_level = log::Level::Err;
-    }
+    LogErrDetailed(const char *filename, int filenumber, LogSite *site = nullptr)
+        : LogDetailed(filename, filenumber, site, log::Level::Err) {}
 };
 
 }  // namespace base
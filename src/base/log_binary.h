@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+/**
+ * Binary log file layout, shared by base::log and the mav_log_decode tool.
+ *
+ * file   : kFileMagic followed by records
+ * record : uint8 type | uint16 payload size | payload
+ * string : uint16 size | bytes
+ * varint : 7 bits per byte, least significant group first, high bit marks more bytes
+ *
+ * All integers are stored in host byte order, every supported board is little endian.
+ */
+namespace base::log::binary {
+
+constexpr char kFileMagic[] = "MAVLOGB1";
+constexpr size_t kFileMagicSize = sizeof(kFileMagic) - 1;
+constexpr size_t kRecordHeaderSize = 3;
+constexpr size_t kMaxPayloadSize = UINT16_MAX;
+constexpr size_t kMaxStringSize = 4096;
+
+enum class RecordType : uint8_t {
+    SiteDefinition = 1,  ///< uint32 site id | uint8 level | uint32 line | string file | string format
+    Message = 2,         ///< uint32 site id | uint64 unix time in us | arguments
+    Dropped = 3,         ///< uint64 unix time in us | uint64 dropped message count
+    Repeated = 4,        ///< uint32 site id | uint64 unix time in us | uint32 suppressed count
+};
+
+/**
+ * @brief argument type tag, every argument of a message is tag followed by value
+ * @details the format of a site holds one "{}" for each argument, literal braces are doubled
+ */
+enum class ArgType : uint8_t {
+    Int = 1,     ///< zigzag encoded varint
+    UInt = 2,    ///< varint
+    Double = 3,  ///< double
+    Bool = 4,    ///< uint8
+    Char = 5,    ///< char
+    String = 6,  ///< string
+};
+
+template <typename Output, typename T>
+inline void put(Output &out, T value) {
+    static_assert(std::is_trivially_copyable_v<T>, "only plain values can be stored");
+    char bytes[sizeof(T)];
+    memcpy(bytes, &value, sizeof(T));
+    out.append(bytes, sizeof(T));
+}
+
+template <typename Output>
+inline void put_varint(Output &out, uint64_t value) {
+    char bytes[10];
+    size_t size = 0;
+    while (value >= 0x80) {
+        bytes[size++] = static_cast<char>((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    bytes[size++] = static_cast<char>(value);
+    out.append(bytes, size);
+}
+
+template <typename Output>
+inline void put_zigzag(Output &out, int64_t value) {
+    put_varint(out, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+template <typename Output>
+inline void put_string(Output &out, std::string_view value) {
+    if (value.size() > kMaxStringSize) {
+        value = value.substr(0, kMaxStringSize);
+    }
+    put(out, static_cast<uint16_t>(value.size()));
+    out.append(value.data(), value.size());
+}
+
+template <typename T>
+inline bool get(const char *&data, const char *end, T &value) {
+    if (static_cast<size_t>(end - data) < sizeof(T)) {
+        return false;
+    }
+    memcpy(&value, data, sizeof(T));
+    data += sizeof(T);
+    return true;
+}
+
+inline bool get_varint(const char *&data, const char *end, uint64_t &value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && data < end; shift += 7) {
+        uint8_t byte = static_cast<uint8_t>(*data++);
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+inline bool get_zigzag(const char *&data, const char *end, int64_t &value) {
+    uint64_t raw = 0;
+    if (!get_varint(data, end, raw)) {
+        return false;
+    }
+    value = static_cast<int64_t>(raw >> 1) ^ -static_cast<int64_t>(raw & 1);
+    return true;
+}
+
+inline bool get_string(const char *&data, const char *end, std::string_view &value) {
+    uint16_t size = 0;
+    if (!get(data, end, size) || static_cast<size_t>(end - data) < size) {
+        return false;
+    }
+    value = std::string_view(data, size);
+    data += size;
+    return true;
+}
+
+/**
+ * @brief append a record header with an empty payload size, return the record offset
+ */
+inline size_t begin_record(std::string &out, RecordType type) {
+    size_t offset = out.size();
+    put(out, static_cast<uint8_t>(type));
+    put(out, static_cast<uint16_t>(0));
+    return offset;
+}
+
+/**
+ * @brief patch payload size of the record at offset
+ * @return false if payload is too large for one record
+ */
+inline bool end_record(std::string &out, size_t offset) {
+    size_t payload_size = out.size() - offset - kRecordHeaderSize;
+    if (payload_size > kMaxPayloadSize) {
+        return false;
+    }
+    uint16_t size = static_cast<uint16_t>(payload_size);
+    memcpy(&out[offset + 1], &size, sizeof(size));
+    return true;
+}
+
+}  // namespace base::log::binary
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <functional>
 #include <string>
 
@@ -22,4 +23,21 @@ using Callback =
 extern Callback &get_callback();
 extern void subscribe(const Callback &callback);
 
+/**
+ * @brief User-defined callback for binary logging, it receives complete binary log records.
+ * When it is set, messages are encoded to binary instead of text, text callback and stdout
+ * output are skipped. Each call is one record, a site definition comes before the first
+ * message of its call site.
+ */
+using BinaryCallback = std::function<void(const char *data, size_t size)>;
+
+extern BinaryCallback &get_binary_callback();
+extern void subscribe_binary(const BinaryCallback &callback);
+
+/**
+ * @brief messages below minimum level are dropped before formatting, default is Debug
+ */
+extern void set_min_level(Level level);
+extern Level get_min_level();
+
 }  // namespace base::log
@@ -0,0 +1,138 @@
+#include "log_rate_limiter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+
+namespace base {
+
+// depth of RateLimitExemptScope on this thread
+static thread_local int exempt_depth = 0;
+
+LogRateLimiter::LogRateLimiter() {
+    // periodic messages are polled a few times per second, keep a short burst for each site
+    set_budget(log::Level::Debug, {2, 10});
+    set_budget(log::Level::Info, {5, 10});
+    set_budget(log::Level::Warn, {10, 20});
+    // errors are rare and each one matters, they are never suppressed
+    set_budget(log::Level::Err, {0, 0});
+}
+
+void LogRateLimiter::set_budget(log::Level level, Budget budget) {
+    int index = static_cast<int>(level);
+    _rates[index].store(budget.rate, std::memory_order_relaxed);
+    _bursts[index].store(std::max<uint32_t>(budget.burst, 1), std::memory_order_relaxed);
+}
+
+LogRateLimiter::Budget LogRateLimiter::get_budget(log::Level level) const {
+    int index = static_cast<int>(level);
+    return Budget{_rates[index].load(std::memory_order_relaxed),
+                  _bursts[index].load(std::memory_order_relaxed)};
+}
+
+void LogRateLimiter::disable() {
+    for (int i = 0; i < kLevelCount; i++) {
+        set_budget(static_cast<log::Level>(i), {0, 0});
+    }
+}
+
+bool LogRateLimiter::allow(log::Level level, State &state, uint32_t &repeated,
+                           const Source &source) {
+    return allow(level, state, repeated, source, Sites::Static);
+}
+
+bool LogRateLimiter::allow(log::Level level, uint64_t key, uint32_t &repeated,
+                           const Source &source) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return allow(level, _keyed_states[key], repeated, source, Sites::Keyed);
+}
+
+bool LogRateLimiter::allow(log::Level level, State &state, uint32_t &repeated,
+                           const Source &source, Sites sites) {
+    repeated = 0;
+    Budget budget = get_budget(level);
+    int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      std::chrono::steady_clock::now().time_since_epoch())
+                      .count();
+
+    // critical section is a few instructions, spin instead of a mutex for each site
+    while (state.lock.exchange(true, std::memory_order_acquire)) {
+    }
+    bool allowed = true;
+    if (budget.rate == 0 || exempt_depth > 0) {
+        state.tokens = budget.burst;
+    } else if (state.last_refill_ns == 0) {
+        state.tokens = budget.burst - 1;
+    } else {
+        double refill = static_cast<double>(now - state.last_refill_ns) * budget.rate / 1e9;
+        state.tokens = std::min(state.tokens + refill, static_cast<double>(budget.burst));
+        allowed = state.tokens >= 1;
+        if (allowed) {
+            state.tokens -= 1;
+        }
+    }
+    state.last_refill_ns = now;
+    bool queue = false;
+    if (allowed) {
+        repeated = state.suppressed;
+        state.suppressed = 0;
+    } else {
+        state.suppressed++;
+        queue = !state.pending && source.file != nullptr;
+        state.pending = state.pending || queue;
+    }
+    state.lock.store(false, std::memory_order_release);
+
+    if (queue) {
+        // only the first suppressed message of a burst gets here
+        std::lock_guard<std::mutex> lock(_pending_mutex);
+        _pending.push_back(Pending{&state, sites, {level, source.file, source.line,
+                                                   source.site_id, 0}});
+    }
+    return allowed;
+}
+
+void LogRateLimiter::flush_suppressed(Sites sites,
+                                      const std::function<void(const Suppressed &)> &callback) {
+    std::vector<Pending> flushed;
+    {
+        std::lock_guard<std::mutex> lock(_pending_mutex);
+        auto split = std::stable_partition(_pending.begin(), _pending.end(),
+                                           [sites](const Pending &p) { return p.sites != sites; });
+        flushed.assign(std::make_move_iterator(split), std::make_move_iterator(_pending.end()));
+        _pending.erase(split, _pending.end());
+    }
+    for (auto &pending : flushed) {
+        State &state = *pending.state;
+        while (state.lock.exchange(true, std::memory_order_acquire)) {
+        }
+        // count is zero when the site logged again and reported it itself
+        pending.suppressed.count = state.suppressed;
+        state.suppressed = 0;
+        state.pending = false;
+        state.lock.store(false, std::memory_order_release);
+        if (pending.suppressed.count > 0) {
+            callback(pending.suppressed);
+        }
+    }
+}
+
+namespace log {
+
+LogRateLimiter &get_rate_limiter() {
+    // never destroyed, threads may still log while static objects are destructed at exit
+    static LogRateLimiter *rate_limiter = new LogRateLimiter();
+    return *rate_limiter;
+}
+
+RateLimitExemptScope::RateLimitExemptScope() {
+    exempt_depth++;
+}
+
+RateLimitExemptScope::~RateLimitExemptScope() {
+    exempt_depth--;
+}
+
+}  // namespace log
+
+}  // namespace base
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "log_callback.h"
+
+namespace base {
+
+/**
+ * @brief Token bucket rate limiter for log call sites
+ * @details Every call site owns one bucket, the refill rate and burst size depend on the level
+ * of the message. Suppressed messages are counted and reported as "N messages suppressed at
+ * file:line" with the next message let through on that site, or by flush_suppressed() when the
+ * site stays quiet.
+ */
+class LogRateLimiter final {
+public:
+    struct Budget {
+        uint32_t rate{0};   ///< messages per second, 0 means unlimited
+        uint32_t burst{0};  ///< messages allowed at once
+    };
+
+    /**
+     * @brief bucket of one call site, constant initialized so it can live in a static LogSite
+     */
+    struct State {
+        std::atomic<bool> lock{false};
+        int64_t last_refill_ns{0};
+        double tokens{0};
+        uint32_t suppressed{0};
+        bool pending{false};  ///< queued for flush_suppressed()
+    };
+
+    /**
+     * @brief location a suppressed count is reported for
+     */
+    struct Source {
+        const char *file{nullptr};  ///< nullptr when the count is only reported on next message
+        int line{0};
+        uint32_t site_id{0};  ///< binary log site id, 0 when not assigned
+    };
+
+    /**
+     * @brief which states flush_suppressed() reports
+     */
+    enum class Sites {
+        Static,  ///< states of LogSite, the base log call sites
+        Keyed,   ///< states of keyed allow(), e.g. MAVSDK log callback
+    };
+
+    struct Suppressed {
+        log::Level level{log::Level::Debug};
+        std::string file{};
+        int line{0};
+        uint32_t site_id{0};
+        uint32_t count{0};
+    };
+public:
+    LogRateLimiter();
+    ~LogRateLimiter() = default;
+public:
+    void set_budget(log::Level level, Budget budget);
+    Budget get_budget(log::Level level) const;
+    /**
+     * @brief set every level unlimited
+     */
+    void disable();
+    /**
+     * @brief take one token from the bucket of a call site
+     * @param repeated count of messages suppressed on this site since last allowed one
+     * @param source where flush_suppressed() reports the count, state must outlive the limiter
+     * @return false when message should be suppressed
+     */
+    bool allow(log::Level level, State &state, uint32_t &repeated, const Source &source);
+    /**
+     * @brief same as above for callers without a static call site, e.g. MAVSDK log callback
+     */
+    bool allow(log::Level level, uint64_t key, uint32_t &repeated, const Source &source);
+    /**
+     * @brief report and reset counts of sites that suppressed messages and did not log since
+     * @details called by the log sink writer on a timer, so a site that went quiet after a
+     * burst does not keep its count until it logs again
+     */
+    void flush_suppressed(Sites sites, const std::function<void(const Suppressed &)> &callback);
+public:
+    LogRateLimiter(const LogRateLimiter &) = delete;
+    void operator=(const LogRateLimiter &) = delete;
+private:
+    static constexpr int kLevelCount = 4;
+    std::atomic<uint32_t> _rates[kLevelCount];
+    std::atomic<uint32_t> _bursts[kLevelCount];
+    std::mutex _mutex{};
+    std::unordered_map<uint64_t, State> _keyed_states{};
+private:
+    struct Pending {
+        State *state{nullptr};
+        Sites sites{Sites::Static};
+        Suppressed suppressed{};
+    };
+    bool allow(log::Level level, State &state, uint32_t &repeated, const Source &source,
+               Sites sites);
+private:
+    std::mutex _pending_mutex{};
+    std::vector<Pending> _pending{};
+};
+
+namespace log {
+
+/**
+ * @brief limiter used by LogDebug(), LogInfo(), LogWarn() and LogError()
+ */
+extern LogRateLimiter &get_rate_limiter();
+
+/**
+ * @brief messages of the calling thread are not rate limited while it lives
+ * @details for dumps logged from one site in a loop, e.g. all settings at init, which would lose
+ * everything after the burst of that site
+ */
+class RateLimitExemptScope final {
+public:
+    RateLimitExemptScope();
+    ~RateLimitExemptScope();
+public:
+    RateLimitExemptScope(const RateLimitExemptScope &) = delete;
+    void operator=(const RateLimitExemptScope &) = delete;
+};
+
+}  // namespace log
+
+}  // namespace base
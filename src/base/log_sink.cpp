@@ -0,0 +1,400 @@
+#include "log_sink.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+
+#include "log.h"
+#include "log_binary.h"
+
+namespace base {
+
+static const char *level_tag(log::Level level) {
+    switch (level) {
+        case log::Level::Debug:
+            return "Debug";
+        case log::Level::Info:
+            return "Info ";
+        case log::Level::Warn:
+            return "Warn ";
+        case log::Level::Err:
+            return "Error";
+    }
+    return "Unknown";
+}
+
+static size_t round_up_power_of_two(size_t value) {
+    size_t result = 2;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+AsyncLogSink::AsyncLogSink() {}
+
+AsyncLogSink::~AsyncLogSink() {
+    close();
+}
+
+bool AsyncLogSink::open(const std::string &path, const Options &options) {
+    if (_running.load()) {
+        LogWarn() << "Log sink already opened";
+        return false;
+    }
+    _path = path;
+    _options = options;
+    if (_options.max_file_size > 0 && _options.max_files < 2) {
+        // a single file would be truncated by each rotation, keep the previous one at least
+        LogWarn() << "Log rotation keeps 2 files of " << path << " instead of "
+                  << _options.max_files;
+        _options.max_files = 2;
+    }
+    _definitions.clear();
+    if (!open_file()) {
+        LogError() << "Cannot open log file " << path << " : " << strerror(errno);
+        return false;
+    }
+    size_t capacity = round_up_power_of_two(options.capacity);
+    _slots.reset(new Slot[capacity]);
+    for (size_t i = 0; i < capacity; i++) {
+        _slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    _mask = capacity - 1;
+    _enqueue_pos.store(0, std::memory_order_relaxed);
+    _dequeue_pos.store(0, std::memory_order_relaxed);
+    _dropped.store(0);
+    _reported_dropped = 0;
+    _suppressed_reported = std::chrono::steady_clock::now();
+    _should_exit = false;
+    _flush_request = 0;
+    _flush_done = 0;
+    _running.store(true);
+    _work_thread = new std::thread(work_thread, this);
+    return true;
+}
+
+bool AsyncLogSink::push(log::Level level, const std::string &message) {
+    return push_slot(level, false, message.data(), message.size(), _options.overflow_policy);
+}
+
+bool AsyncLogSink::push_record(const char *data, size_t size) {
+    if (size < log::binary::kRecordHeaderSize) {
+        return false;
+    }
+    OverflowPolicy overflow_policy = _options.overflow_policy;
+    if (static_cast<log::binary::RecordType>(data[0]) ==
+        log::binary::RecordType::SiteDefinition) {
+        overflow_policy = OverflowPolicy::Block;
+    }
+    return push_slot(log::Level::Debug, true, data, size, overflow_policy);
+}
+
+bool AsyncLogSink::push_slot(log::Level level, bool record, const char *data, size_t size,
+                             OverflowPolicy overflow_policy) {
+    if (!_running.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    while (!try_push(level, record, data, size)) {
+        if (overflow_policy == OverflowPolicy::Drop ||
+            !_running.load(std::memory_order_relaxed)) {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        // sleep until writer frees slots, timeout guards the notify racing with this wait
+        std::unique_lock<std::mutex> lock(_wake_mutex);
+        _wake_cv.notify_one();
+        _space_cv.wait_for(lock, std::chrono::milliseconds(1));
+    }
+    // wake writer early when ring buffer is half full, otherwise it wakes up by flush interval
+    if (is_high_water()) {
+        wake_writer();
+    }
+    return true;
+}
+
+void AsyncLogSink::flush() {
+    if (!_running.load()) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(_wake_mutex);
+    uint64_t request = ++_flush_request;
+    _wake_cv.notify_one();
+    _flushed_cv.wait(lock, [this, request] { return _flush_done >= request || _should_exit; });
+}
+
+void AsyncLogSink::close() {
+    _running.store(false);
+    if (_work_thread != nullptr) {
+        {
+            std::lock_guard<std::mutex> lock(_wake_mutex);
+            _should_exit = true;
+        }
+        _wake_cv.notify_one();
+        _work_thread->join();
+        delete _work_thread;
+        _work_thread = nullptr;
+    }
+    close_file();
+}
+
+uint64_t AsyncLogSink::dropped_count() const {
+    return _dropped.load(std::memory_order_relaxed);
+}
+
+bool AsyncLogSink::try_push(log::Level level, bool record, const char *data, size_t size) {
+    size_t pos = _enqueue_pos.load(std::memory_order_relaxed);
+    Slot *slot = nullptr;
+    while (true) {
+        slot = &_slots[pos & _mask];
+        size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            if (_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;  // ring buffer is full
+        } else {
+            pos = _enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+    slot->level = level;
+    slot->record = record;
+    slot->time = std::chrono::system_clock::now();
+    // slot keeps the string capacity, so no allocation after the first round
+    slot->message.assign(data, size);
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+size_t AsyncLogSink::drain(std::string &batch) {
+    size_t count = 0;
+    time_t last_second = 0;
+    char time_buffer[16] = {0};
+    size_t pos = _dequeue_pos.load(std::memory_order_relaxed);
+    while (true) {
+        Slot *slot = &_slots[pos & _mask];
+        size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        if (static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1) < 0) {
+            break;  // empty or producer still filling this slot
+        }
+        if (slot->record) {
+            batch.append(slot->message);
+            if (static_cast<log::binary::RecordType>(slot->message[0]) ==
+                log::binary::RecordType::SiteDefinition) {
+                _definitions.append(slot->message);
+            }
+        } else {
+            time_t now = std::chrono::system_clock::to_time_t(slot->time);
+            if (now != last_second) {
+                struct tm local_time;
+                localtime_r(&now, &local_time);
+                strftime(time_buffer, sizeof(time_buffer), "%I:%M:%S", &local_time);
+                last_second = now;
+            }
+            batch.append("[").append(time_buffer).append("|").append(level_tag(slot->level));
+            batch.append("]  ").append(slot->message).append("\n");
+        }
+        slot->sequence.store(pos + _mask + 1, std::memory_order_release);
+        pos++;
+        _dequeue_pos.store(pos, std::memory_order_relaxed);
+        count++;
+    }
+
+    uint64_t dropped = _dropped.load(std::memory_order_relaxed);
+    if (dropped != _reported_dropped) {
+        if (_options.format == Format::Binary) {
+            auto now = std::chrono::system_clock::now().time_since_epoch();
+            size_t offset = log::binary::begin_record(batch, log::binary::RecordType::Dropped);
+            log::binary::put(batch, static_cast<uint64_t>(
+                                        std::chrono::duration_cast<std::chrono::microseconds>(now)
+                                            .count()));
+            log::binary::put(batch, static_cast<uint64_t>(dropped - _reported_dropped));
+            log::binary::end_record(batch, offset);
+        } else {
+            if (time_buffer[0] == '\0') {
+                time_t now = time(nullptr);
+                struct tm local_time;
+                localtime_r(&now, &local_time);
+                strftime(time_buffer, sizeof(time_buffer), "%I:%M:%S", &local_time);
+            }
+            char buffer[64];
+            snprintf(buffer, sizeof(buffer), "[%s|Warn ]  %llu log messages dropped\n",
+                     time_buffer, static_cast<unsigned long long>(dropped - _reported_dropped));
+            batch.append(buffer);
+        }
+        _reported_dropped = dropped;
+    }
+    return count;
+}
+
+void AsyncLogSink::report_suppressed(std::string &batch) {
+    auto now = std::chrono::steady_clock::now();
+    if (_options.suppressed_interval.count() <= 0 ||
+        now - _suppressed_reported < _options.suppressed_interval) {
+        return;
+    }
+    _suppressed_reported = now;
+    log::get_rate_limiter().flush_suppressed(
+        _options.suppressed_sites, [this, &batch](const LogRateLimiter::Suppressed &suppressed) {
+            if (_options.format == Format::Binary) {
+                if (suppressed.site_id == 0) {
+                    return;  // no site definition to refer to
+                }
+                auto time = std::chrono::system_clock::now().time_since_epoch();
+                size_t offset =
+                    log::binary::begin_record(batch, log::binary::RecordType::Repeated);
+                log::binary::put(batch, suppressed.site_id);
+                log::binary::put(batch, static_cast<uint64_t>(
+                                            std::chrono::duration_cast<std::chrono::microseconds>(
+                                                time)
+                                                .count()));
+                log::binary::put(batch, suppressed.count);
+                log::binary::end_record(batch, offset);
+                return;
+            }
+            char time_buffer[16] = {0};
+            time_t time = ::time(nullptr);
+            struct tm local_time;
+            localtime_r(&time, &local_time);
+            strftime(time_buffer, sizeof(time_buffer), "%I:%M:%S", &local_time);
+            batch.append("[").append(time_buffer).append("|").append(level_tag(suppressed.level));
+            batch.append("]  ").append(std::to_string(suppressed.count));
+            batch.append(" messages suppressed at ").append(suppressed.file).append(":");
+            batch.append(std::to_string(suppressed.line)).append("\n");
+        });
+}
+
+bool AsyncLogSink::open_file() {
+    // shift path.N-2 -> path.N-1 ... path -> path.1, the oldest file is replaced
+    for (size_t i = _options.max_files; i > 1; i--) {
+        std::string from = i == 2 ? _path : _path + "." + std::to_string(i - 2);
+        std::string to = _path + "." + std::to_string(i - 1);
+        ::rename(from.c_str(), to.c_str());
+    }
+
+    _fd = ::open(_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (_fd < 0) {
+        return false;
+    }
+    _file_size = 0;
+    if (_options.max_file_size > 0) {
+        // allocate blocks once instead of growing the file on every write, file size is kept
+        // so readers never see the unwritten tail. Not all file systems support it.
+        if (fallocate(_fd, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(_options.max_file_size)) <
+            0) {
+            warn_allocation("fallocate");
+        }
+    }
+    if (_options.format == Format::Binary) {
+        std::string head(log::binary::kFileMagic, log::binary::kFileMagicSize);
+        head.append(_definitions);
+        write_batch(head);
+    }
+    _head_size = _file_size;
+    return true;
+}
+
+void AsyncLogSink::close_file() {
+    if (_fd < 0) {
+        return;
+    }
+    // release preallocated blocks behind the written data
+    if (_options.max_file_size > 0 && ftruncate(_fd, static_cast<off_t>(_file_size)) < 0) {
+        warn_allocation("ftruncate");
+    }
+    ::close(_fd);
+    _fd = -1;
+}
+
+void AsyncLogSink::warn_allocation(const char *call) {
+    // the file system behaves the same for every file, logging keeps going without it
+    if (_allocation_warned) {
+        return;
+    }
+    _allocation_warned = true;
+    LogWarn() << call << " of log file " << _path << " failed : " << strerror(errno);
+}
+
+void AsyncLogSink::rotate_if_needed(size_t incoming_size) {
+    if (_options.max_file_size == 0 || _file_size <= _head_size ||
+        _file_size + incoming_size <= _options.max_file_size) {
+        return;
+    }
+    close_file();
+    open_file();
+}
+
+void AsyncLogSink::write_batch(const std::string &batch) {
+    if (_fd < 0) {
+        return;
+    }
+    const char *data = batch.data();
+    size_t remain = batch.size();
+    while (remain > 0) {
+        ssize_t written = ::write(_fd, data, remain);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;  // nowhere to report, keep running and try again with next batch
+        }
+        data += written;
+        remain -= written;
+        _file_size += written;
+    }
+}
+
+void AsyncLogSink::wake_writer() {
+    _wake_cv.notify_one();
+}
+
+bool AsyncLogSink::is_high_water() const {
+    size_t pending = _enqueue_pos.load(std::memory_order_relaxed) -
+                     _dequeue_pos.load(std::memory_order_relaxed);
+    return pending > (_mask >> 1);
+}
+
+void AsyncLogSink::work_thread(AsyncLogSink *self) {
+    std::string batch;
+    batch.reserve(16 * 1024);
+    while (true) {
+        bool should_exit = false;
+        uint64_t flush_request = 0;
+        {
+            std::unique_lock<std::mutex> lock(self->_wake_mutex);
+            self->_wake_cv.wait_for(lock, self->_options.flush_interval, [self] {
+                return self->_should_exit || self->_flush_request != self->_flush_done ||
+                       self->is_high_water();
+            });
+            should_exit = self->_should_exit;
+            flush_request = self->_flush_request;
+        }
+
+        batch.clear();
+        if (self->drain(batch) > 0) {
+            self->_space_cv.notify_all();
+        }
+        self->report_suppressed(batch);
+        if (!batch.empty()) {
+            self->rotate_if_needed(batch.size());
+            self->write_batch(batch);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(self->_wake_mutex);
+            self->_flush_done = flush_request;
+        }
+        self->_flushed_cv.notify_all();
+        if (should_exit) {
+            break;
+        }
+    }
+}
+
+}  // namespace base
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "log_callback.h"
+#include "log_rate_limiter.h"
+
+namespace base {
+
+/**
+ * @brief Asynchronous log file sink
+ * @details Producers copy the message into a bounded lock-free MPSC ring buffer and return,
+ * a single background thread drains the ring buffer, formats the lines and writes them
+ * to file in batches. So the calling thread never waits for the storage device.
+ */
+class AsyncLogSink final {
+public:
+    enum class OverflowPolicy {
+        Drop,   ///< drop the message and count it when ring buffer is full
+        Block,  ///< wait until the writer thread frees a slot
+    };
+
+    enum class Format {
+        Text,    ///< one formatted line per message
+        Binary,  ///< binary log records, see log_binary.h
+    };
+
+    struct Options {
+        size_t capacity{1024};  ///< ring buffer slots, rounded up to power of two
+        OverflowPolicy overflow_policy{OverflowPolicy::Drop};
+        Format format{Format::Text};
+        std::chrono::milliseconds flush_interval{200};  ///< max delay before a batch is written
+        size_t max_file_size{0};  ///< rotate when file reaches this size, 0 disables rotation
+        size_t max_files{1};      ///< files kept as path, path.1 ... path.N-1, newest first
+        /// report counts of rate limited sites which stay quiet, 0 disables
+        std::chrono::milliseconds suppressed_interval{0};
+        LogRateLimiter::Sites suppressed_sites{LogRateLimiter::Sites::Static};
+    };
+public:
+    AsyncLogSink();
+    ~AsyncLogSink();
+public:
+    /**
+     * @brief open log file and start the writer thread
+     * @details with max_files > 1 existing files are shifted to keep the history of previous
+     * runs, each file is preallocated to max_file_size. Rotation keeps at least 2 files, so
+     * the file being rotated out is never truncated
+     */
+    bool open(const std::string &path, const Options &options);
+    /**
+     * @brief queue one message, never touch the file on calling thread
+     * @return false when message is dropped
+     */
+    bool push(log::Level level, const std::string &message);
+    /**
+     * @brief queue one binary log record, only for Format::Binary
+     * @details site definitions are never dropped, decoder needs them for every message
+     */
+    bool push_record(const char *data, size_t size);
+    /**
+     * @brief block until all queued messages are written to file
+     */
+    void flush();
+    /**
+     * @brief flush pending messages, stop writer thread and close the file
+     * @details this is the flush-on-shutdown hook, also called by destructor
+     */
+    void close();
+    /**
+     * @brief total count of messages dropped by overflow policy
+     */
+    uint64_t dropped_count() const;
+public:
+    AsyncLogSink(const AsyncLogSink &) = delete;
+    void operator=(const AsyncLogSink &) = delete;
+private:
+    struct Slot {
+        std::atomic<size_t> sequence{0};
+        log::Level level{log::Level::Debug};
+        bool record{false};
+        std::chrono::system_clock::time_point time{};
+        std::string message{};
+    };
+private:
+    bool push_slot(log::Level level, bool record, const char *data, size_t size,
+                   OverflowPolicy overflow_policy);
+    bool try_push(log::Level level, bool record, const char *data, size_t size);
+    size_t drain(std::string &batch);
+    void report_suppressed(std::string &batch);
+    bool open_file();
+    void close_file();
+    void warn_allocation(const char *call);
+    void rotate_if_needed(size_t incoming_size);
+    void write_batch(const std::string &batch);
+    void wake_writer();
+    bool is_high_water() const;
+    static void work_thread(AsyncLogSink *self);
+private:
+    Options _options{};
+    std::string _path{};
+    int _fd{-1};
+    size_t _file_size{0};
+    size_t _head_size{0};
+    bool _allocation_warned{false};
+    std::string _definitions{};  ///< binary site definitions, repeated at the head of each file
+    std::unique_ptr<Slot[]> _slots;
+    size_t _mask{0};
+    alignas(64) std::atomic<size_t> _enqueue_pos{0};
+    alignas(64) std::atomic<size_t> _dequeue_pos{0};
+    std::atomic<uint64_t> _dropped{0};
+    uint64_t _reported_dropped{0};
+    std::chrono::steady_clock::time_point _suppressed_reported{};
+private:  // writer thread
+    std::thread *_work_thread{nullptr};
+    std::atomic<bool> _running{false};
+    std::mutex _wake_mutex{};
+    std::condition_variable _wake_cv{};
+    std::condition_variable _space_cv{};
+    std::condition_variable _flushed_cv{};
+    bool _should_exit{false};
+    uint64_t _flush_request{0};
+    uint64_t _flush_done{0};
+};
+
+}  // namespace base
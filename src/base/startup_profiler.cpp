@@ -0,0 +1,116 @@
+#include "startup_profiler.h"
+
+#include <unistd.h>
+
+#include <fstream>
+#include <sstream>
+
+#include "file_operation.h"
+#include "log.h"
+
+namespace base {
+
+static int64_t to_ms(std::chrono::steady_clock::time_point time) {
+    // steady clock is CLOCK_MONOTONIC, its epoch is boot
+    return std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count();
+}
+
+/**
+ * @brief start of this process in ms since boot, -1 when unknown
+ */
+static int64_t process_start_ms() {
+    std::ifstream file("/proc/self/stat");
+    std::string stat;
+    if (!std::getline(file, stat)) {
+        return -1;
+    }
+    // the command name may contain spaces, fields are counted after its closing parenthesis
+    size_t pos = stat.rfind(')');
+    if (pos == std::string::npos) {
+        return -1;
+    }
+    std::istringstream fields(stat.substr(pos + 2));
+    std::string field;
+    // starttime is field 22 of the file, the 20th after the command name
+    for (int i = 0; i < 20 && fields >> field; i++) {
+    }
+    long ticks = sysconf(_SC_CLK_TCK);
+    if (!fields || ticks <= 0) {
+        return -1;
+    }
+    return std::stoll(field) * 1000 / ticks;
+}
+
+StartupProfiler &StartupProfiler::instance() {
+    static StartupProfiler profiler;
+    return profiler;
+}
+
+void StartupProfiler::set_report(const std::string &process, const std::string &path) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _process = process;
+    _report_path = path;
+}
+
+void StartupProfiler::record(const std::string &name, std::chrono::steady_clock::time_point start,
+                             std::chrono::steady_clock::time_point end) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _phases.push_back(Phase{name, to_ms(start), to_ms(end) - to_ms(start)});
+    if (_ready_ms >= 0) {
+        LogInfo() << "Startup phase " << name << " took " << _phases.back().duration_ms
+                  << " ms after ready";
+        write_report_locked();
+    }
+}
+
+void StartupProfiler::finish() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _ready_ms = to_ms(std::chrono::steady_clock::now());
+    LogInfo() << "Startup report " << to_json_locked();
+    write_report_locked();
+}
+
+std::string StartupProfiler::to_json() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return to_json_locked();
+}
+
+std::string StartupProfiler::to_json_locked() const {
+    // names are identifiers chosen in code, they never need escaping
+    std::ostringstream json;
+    json << "{\"process\":\"" << _process << "\",\"process_start_ms\":" << process_start_ms()
+         << ",\"ready_ms\":" << _ready_ms << ",\"phases\":[";
+    for (size_t i = 0; i < _phases.size(); i++) {
+        const Phase &phase = _phases[i];
+        json << (i > 0 ? "," : "") << "{\"name\":\"" << phase.name
+             << "\",\"start_ms\":" << phase.start_ms << ",\"duration_ms\":" << phase.duration_ms
+             << "}";
+    }
+    json << "]}";
+    return json.str();
+}
+
+void StartupProfiler::write_report_locked() const {
+    if (_report_path.empty()) {
+        return;
+    }
+    if (!write_file_atomic(_report_path, to_json_locked() + "\n")) {
+        LogWarn() << "Cannot write startup report " << _report_path;
+    }
+}
+
+StartupPhase::StartupPhase(const char *name)
+    : _name(name), _start(std::chrono::steady_clock::now()) {}
+
+StartupPhase::~StartupPhase() {
+    stop();
+}
+
+void StartupPhase::stop() {
+    if (_running) {
+        _running = false;
+        StartupProfiler::instance().record(_name, _start, std::chrono::steady_clock::now());
+    }
+}
+
+}  // namespace base
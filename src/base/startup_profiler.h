@@ -0,0 +1,71 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace base {
+
+/**
+ * @brief Timing of the startup phases of a process
+ * @details times come from the monotonic clock and are reported as ms since boot, so phases of
+ * mav_client and mav_server line up. finish() logs one summary line and writes the report as
+ * json, phases that end later, like a device coming up in background, update the report file,
+ * so it always shows the current state while the process runs.
+ */
+class StartupProfiler final {
+public:
+    struct Phase {
+        std::string name{};
+        int64_t start_ms{0};  ///< ms since boot
+        int64_t duration_ms{0};
+    };
+public:
+    static StartupProfiler &instance();
+public:
+    /**
+     * @brief name of the process in the report and path of the json report, empty for none
+     */
+    void set_report(const std::string &process, const std::string &path);
+    void record(const std::string &name, std::chrono::steady_clock::time_point start,
+                std::chrono::steady_clock::time_point end);
+    /**
+     * @brief mark the process ready, log the summary and write the report
+     */
+    void finish();
+    std::string to_json() const;
+private:
+    StartupProfiler() = default;
+    std::string to_json_locked() const;
+    void write_report_locked() const;
+private:
+    mutable std::mutex _mutex{};
+    std::string _process{};
+    std::string _report_path{};
+    std::vector<Phase> _phases{};
+    int64_t _ready_ms{-1};  ///< -1 until finish()
+};
+
+/**
+ * @brief Times the enclosing scope as one startup phase
+ */
+class StartupPhase final {
+public:
+    explicit StartupPhase(const char *name);
+    ~StartupPhase();
+    StartupPhase(const StartupPhase &) = delete;
+    StartupPhase &operator=(const StartupPhase &) = delete;
+public:
+    /**
+     * @brief end the phase before the scope ends
+     */
+    void stop();
+private:
+    const char *_name;
+    std::chrono::steady_clock::time_point _start;
+    bool _running{true};
+};
+
+}  // namespace base
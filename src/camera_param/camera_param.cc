@@ -1,49 +1,170 @@
 #include "camera_param.h"
 
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
 #include "base/log.h"
+#include "base/startup_profiler.h"
+#include "json/json.h"
 
 namespace mavcam {
 
-std::string kDefaultStorePath = "/data/camera/cam_param.bin";
+std::string kDefaultStorePath = "/data/camera/cam_param.db";
+// json file of older versions, imported once into the store
+static const char *kLegacyStorePath = "/data/camera/cam_param.bin";
+// sync once changes are quiet for kFlushDelay, but never hold them longer than kMaxFlushDelay
+static constexpr auto kFlushDelay = std::chrono::milliseconds(500);
+static constexpr auto kMaxFlushDelay = std::chrono::seconds(3);
+// backoff of a failing sync, e.g. storage full or read only
+static constexpr auto kMaxRetryDelay = std::chrono::seconds(60);
 
 std::string CameraParam::get_value(const std::string &key) {
-    return _root[key].asString();
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::string value;
+    _store.get(key, value);
+    return value;
 }
 
 bool CameraParam::set_value(const std::string &key, const std::string &value) {
-    std::ofstream ofs(kDefaultStorePath, std::ofstream::trunc);
-    if (!ofs.is_open()) {
-        base::LogError() << "Error: Could not open file " << kDefaultStorePath << " for writing";
-        return false;
+    return set_values({{key, value}});
+}
+
+bool CameraParam::set_values(const std::vector<std::pair<std::string, std::string>> &values) {
+    bool result = true;
+    bool changed = false;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (const auto &[key, value] : values) {
+            std::string current;
+            if (_store.get(key, current) && current == value) {
+                continue;
+            }
+            if (!_store.set(key, value)) {
+                base::LogError() << "Error: Could not store " << key << " = " << value;
+                result = false;
+                continue;
+            }
+            changed = true;
+        }
+        if (!changed) {
+            return result;
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (!_dirty) {
+            _first_change = now;
+        }
+        _last_change = now;
+        _dirty = true;
     }
+    _cv.notify_one();
+    return result;
+}
 
-    Json::StreamWriterBuilder writerBuilder;
-    writerBuilder["indentation"] = "    ";
-    std::unique_ptr<Json::StreamWriter> writer(writerBuilder.newStreamWriter());
-    _root[key] = value;
-    writer->write(_root, &ofs);  // write back to file
-    ofs.close();
+bool CameraParam::flush() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_dirty) {
+        return true;
+    }
+    // compact early, so a burst of changes never has to wait for a compaction in set_value()
+    bool result = _store.journal_size() > ParamStore::kJournalSlots / 2 ? _store.compact()
+                                                                        : _store.sync();
+    if (!result) {
+        _retry_delay = std::min<std::chrono::steady_clock::duration>(
+            std::max<std::chrono::steady_clock::duration>(_retry_delay * 2, kFlushDelay),
+            kMaxRetryDelay);
+        _retry_time = std::chrono::steady_clock::now() + _retry_delay;
+        base::LogError() << "Error: Could not write file " << kDefaultStorePath << ", retry in "
+                         << std::chrono::duration_cast<std::chrono::milliseconds>(_retry_delay)
+                                .count()
+                         << " ms";
+        return false;
+    }
+    _dirty = false;
+    _retry_delay = {};
+    _retry_time = {};
     return true;
 }
 
 CameraParam::CameraParam() {
-    _ifstream.open(kDefaultStorePath, std::ifstream::binary);
-    if (!_ifstream.is_open()) {
-        base::LogError() << "Error: Could not open file ";
+    base::StartupPhase phase("camera_param_load");
+    load();
+    phase.stop();
+    _work_thread = new std::thread(work_thread, this);
+}
+
+void CameraParam::load() {
+    if (!_store.open(kDefaultStorePath)) {
+        base::LogError() << "Error: Could not open file " << kDefaultStorePath;
         return;
     }
+    if (_store.values().empty()) {
+        migrate_legacy_file();
+    }
+    base::LogDebug() << "Init camera param with " << _store.values().size() << " values";
+}
+
+void CameraParam::migrate_legacy_file() {
+    std::ifstream legacy_file(kLegacyStorePath, std::ifstream::binary);
+    if (!legacy_file.is_open()) {
+        return;
+    }
+    Json::Value root;
     Json::CharReaderBuilder builder;
-    builder["collectComments"] = true;
     JSONCPP_STRING errs;
-    if (!parseFromStream(builder, _ifstream, &_root, &errs)) {
-        base::LogError() << errs;
-        _ifstream.close();
+    if (!parseFromStream(builder, legacy_file, &root, &errs) || !root.isObject()) {
+        base::LogError() << "Error: Could not parse " << kLegacyStorePath << " " << errs;
+        return;
+    }
+    legacy_file.close();
+    for (const auto &key : root.getMemberNames()) {
+        if (!_store.set(key, root[key].asString())) {
+            base::LogWarn() << "Drop camera param " << key << " during migration";
+        }
+    }
+    if (!_store.compact()) {
         return;
     }
-    base::LogDebug() << "Init camera param " << _root;
-    _ifstream.close();
+    std::string migrated_path = std::string(kLegacyStorePath) + ".migrated";
+    rename(kLegacyStorePath, migrated_path.c_str());
+    base::LogInfo() << "Migrated camera param from " << kLegacyStorePath;
 }
 
-CameraParam::~CameraParam() {}
+CameraParam::~CameraParam() {
+    if (_work_thread != nullptr) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _should_exit = true;
+        }
+        _cv.notify_one();
+        _work_thread->join();
+        delete _work_thread;
+        _work_thread = nullptr;
+    }
+    flush();
+}
+
+void CameraParam::work_thread(CameraParam *self) {
+    std::unique_lock<std::mutex> lock(self->_mutex);
+    while (!self->_should_exit) {
+        self->_cv.wait(lock, [self] { return self->_should_exit || self->_dirty; });
+        // debounce, every new change moves the deadline until the max delay is reached
+        while (!self->_should_exit && self->_dirty) {
+            auto deadline =
+                std::min(self->_last_change + kFlushDelay, self->_first_change + kMaxFlushDelay);
+            deadline = std::max(deadline, self->_retry_time);
+            if (std::chrono::steady_clock::now() >= deadline) {
+                break;
+            }
+            self->_cv.wait_until(lock, deadline);
+        }
+        if (self->_should_exit || !self->_dirty) {
+            continue;
+        }
+        lock.unlock();
+        self->flush();
+        lock.lock();
+    }
+}
 
 }  // namespace mavcam
\ No newline at end of file
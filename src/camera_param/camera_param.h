@@ -1,22 +1,58 @@
 #pragma once
 
-#include <fstream>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
-#include "json/json.h"
+#include "param_store.h"
 
 namespace mavcam {
 
+/**
+ * @brief Persistent camera parameters
+ * @details values live in a memory-mapped ParamStore, every change is appended to its journal
+ * right away and a background thread syncs it to storage once values stop changing for a short
+ * while
+ */
 class CameraParam final {
 public:
     std::string get_value(const std::string &key);
     bool set_value(const std::string &key, const std::string &value);
+    /**
+     * @brief store several values as one change
+     */
+    bool set_values(const std::vector<std::pair<std::string, std::string>> &values);
+    /**
+     * @brief sync pending changes to storage immediately, call it before shutdown
+     */
+    bool flush();
 public:
     CameraParam();
     ~CameraParam();
 private:
-    std::ifstream _ifstream;
-    Json::Value _root;
+    void load();
+    /**
+     * @brief import values of the json file used by older versions, once
+     */
+    void migrate_legacy_file();
+    static void work_thread(CameraParam *self);
+private:
+    ParamStore _store{};
+    std::mutex _mutex{};
+    bool _dirty{false};
+    std::chrono::steady_clock::time_point _first_change{};
+    std::chrono::steady_clock::time_point _last_change{};
+    // after a failed sync, no retry before _retry_time, the delay doubles with every failure
+    std::chrono::steady_clock::duration _retry_delay{};
+    std::chrono::steady_clock::time_point _retry_time{};
+private:  // backend flush thread
+    std::thread *_work_thread{nullptr};
+    std::condition_variable _cv{};
+    bool _should_exit{false};
 };
 
 }  // namespace mavcam
\ No newline at end of file
@@ -0,0 +1,275 @@
+#include "param_store.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+
+#include "base/crc32.h"
+#include "base/file_operation.h"
+#include "base/log.h"
+
+namespace mavcam {
+
+static constexpr char kStoreMagic[8] = {'M', 'C', 'P', 'A', 'R', 'A', 'M', '1'};
+static constexpr uint32_t kStoreVersion = 1;
+
+ParamStore::ParamStore() = default;
+
+ParamStore::~ParamStore() {
+    close();
+}
+
+size_t ParamStore::file_size() {
+    static_assert(sizeof(Header) == 64, "header must keep its on disk size");
+    static_assert(sizeof(Record) == 64, "record must keep its on disk size");
+    return sizeof(Header) + (kSnapshotSlots + kJournalSlots) * sizeof(Record);
+}
+
+ParamStore::Record *ParamStore::snapshot() const {
+    return reinterpret_cast<Record *>(_data + sizeof(Header));
+}
+
+ParamStore::Record *ParamStore::journal() const {
+    return snapshot() + kSnapshotSlots;
+}
+
+uint32_t ParamStore::record_crc(const Record &record, uint32_t generation) {
+    // records of an older generation do not match, so a stale journal tail is never replayed
+    uint32_t crc = base::crc32(&generation, sizeof(generation));
+    return base::crc32(&record.key_size, sizeof(Record) - offsetof(Record, key_size), crc);
+}
+
+bool ParamStore::fill_record(Record &record, const std::string &key, const std::string &value,
+                             uint32_t generation) {
+    if (key.empty() || key.size() > kMaxKeySize || value.size() > kMaxValueSize) {
+        return false;
+    }
+    memset(&record, 0, sizeof(record));
+    record.key_size = static_cast<uint8_t>(key.size());
+    record.value_size = static_cast<uint8_t>(value.size());
+    memcpy(record.key, key.data(), key.size());
+    memcpy(record.value, value.data(), value.size());
+    record.crc = record_crc(record, generation);
+    return true;
+}
+
+bool ParamStore::check_record(const Record &record, uint32_t generation) {
+    return record.key_size > 0 && record.key_size <= kMaxKeySize &&
+           record.value_size <= kMaxValueSize && record.crc == record_crc(record, generation);
+}
+
+bool ParamStore::open(const std::string &path) {
+    close();
+    _path = path;
+    if (map_file() && load()) {
+        // bytes behind the replayed journal come from an interrupted append, a later append
+        // must not end up in front of them, start a new generation instead
+        const char *tail = reinterpret_cast<const char *>(&journal()[_journal_count]);
+        const char *end = reinterpret_cast<const char *>(&journal()[kJournalSlots]);
+        if (std::any_of(tail, end, [](char c) { return c != 0; })) {
+            return compact();
+        }
+        return true;
+    }
+    unmap_file();
+    // keep the broken file for analysis and start over with defaults
+    if (access(_path.c_str(), F_OK) == 0) {
+        base::LogWarn() << "Param store " << _path << " is invalid, start with an empty one";
+        std::string broken_path = _path + ".broken";
+        rename(_path.c_str(), broken_path.c_str());
+    }
+    _values.clear();
+    return write_file(1);
+}
+
+void ParamStore::close() {
+    if (_data != nullptr) {
+        sync();
+    }
+    unmap_file();
+    _values.clear();
+    _generation = 0;
+    _journal_count = 0;
+    _sync_begin = 0;
+}
+
+bool ParamStore::get(const std::string &key, std::string &value) const {
+    auto it = _values.find(key);
+    if (it == _values.end()) {
+        return false;
+    }
+    value = it->second;
+    return true;
+}
+
+bool ParamStore::set(const std::string &key, const std::string &value) {
+    if (_data == nullptr) {
+        return false;
+    }
+    Record record;
+    if (!fill_record(record, key, value, _generation)) {
+        base::LogError() << "Param " << key << " = " << value << " exceeds record size";
+        return false;
+    }
+    auto it = _values.find(key);
+    if (it != _values.end() && it->second == value) {
+        return true;
+    }
+    if (it == _values.end() && _values.size() >= kSnapshotSlots) {
+        base::LogError() << "Param store is full, cannot add " << key;
+        return false;
+    }
+    if (_journal_count >= kJournalSlots) {
+        // the snapshot is written from _values, take the old value back if it is not on disk
+        bool existed = it != _values.end();
+        std::string previous = existed ? it->second : std::string();
+        uint32_t generation = _generation;
+        _values[key] = value;
+        if (compact()) {
+            return true;
+        }
+        if (_generation == generation) {
+            if (existed) {
+                _values[key] = previous;
+            } else {
+                _values.erase(key);
+            }
+        }
+        return false;
+    }
+    // a torn copy fails the crc check and ends replay there
+    memcpy(&journal()[_journal_count], &record, sizeof(record));
+    _journal_count++;
+    _values[key] = value;
+    return true;
+}
+
+bool ParamStore::sync() {
+    if (_data == nullptr || _sync_begin >= _journal_count) {
+        return true;
+    }
+    static const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t begin = reinterpret_cast<char *>(&journal()[_sync_begin]) - _data;
+    size_t end = reinterpret_cast<char *>(&journal()[_journal_count]) - _data;
+    begin -= begin % page_size;
+    if (msync(_data + begin, end - begin, MS_SYNC) != 0) {
+        base::LogError() << "Failed to sync " << _path << " : " << std::strerror(errno);
+        return false;
+    }
+    _sync_begin = _journal_count;
+    return true;
+}
+
+bool ParamStore::compact() {
+    if (_data == nullptr) {
+        return false;
+    }
+    return write_file(_generation + 1);
+}
+
+bool ParamStore::write_file(uint32_t generation) {
+    std::string image(file_size(), '\0');
+    Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, kStoreMagic, sizeof(kStoreMagic));
+    header.version = kStoreVersion;
+    header.generation = generation;
+    header.snapshot_slots = kSnapshotSlots;
+    header.journal_slots = kJournalSlots;
+    header.record_size = sizeof(Record);
+    header.crc = base::crc32(&header, offsetof(Header, crc));
+    memcpy(&image[0], &header, sizeof(header));
+
+    size_t offset = sizeof(Header);
+    for (const auto &[key, value] : _values) {
+        Record record;
+        if (fill_record(record, key, value, generation)) {
+            memcpy(&image[offset], &record, sizeof(record));
+            offset += sizeof(record);
+        }
+    }
+
+    // the new file replaces the mapped one, so the old mapping has to go first
+    unmap_file();
+    if (!base::write_file_atomic(_path, image)) {
+        // old file is untouched, keep appending to it
+        map_file();
+        return false;
+    }
+    // the new snapshot is on disk even if it cannot be mapped again
+    _generation = generation;
+    _journal_count = 0;
+    _sync_begin = 0;
+    return map_file();
+}
+
+bool ParamStore::map_file() {
+    _fd = ::open(_path.c_str(), O_RDWR | O_CLOEXEC);
+    if (_fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(_fd, &info) != 0 || static_cast<size_t>(info.st_size) != file_size()) {
+        unmap_file();
+        return false;
+    }
+    void *data = mmap(nullptr, file_size(), PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+    if (data == MAP_FAILED) {
+        base::LogError() << "Failed to map " << _path << " : " << std::strerror(errno);
+        unmap_file();
+        return false;
+    }
+    _data = static_cast<char *>(data);
+    return true;
+}
+
+void ParamStore::unmap_file() {
+    if (_data != nullptr) {
+        munmap(_data, file_size());
+        _data = nullptr;
+    }
+    if (_fd >= 0) {
+        ::close(_fd);
+        _fd = -1;
+    }
+}
+
+bool ParamStore::load() {
+    Header header;
+    memcpy(&header, _data, sizeof(header));
+    if (memcmp(header.magic, kStoreMagic, sizeof(kStoreMagic)) != 0 ||
+        header.crc != base::crc32(&header, offsetof(Header, crc)) ||
+        header.version != kStoreVersion || header.snapshot_slots != kSnapshotSlots ||
+        header.journal_slots != kJournalSlots || header.record_size != sizeof(Record)) {
+        return false;
+    }
+    _generation = header.generation;
+    _values.clear();
+    for (size_t i = 0; i < kSnapshotSlots; i++) {
+        const Record &record = snapshot()[i];
+        if (check_record(record, _generation)) {
+            _values[std::string(record.key, record.key_size)] =
+                std::string(record.value, record.value_size);
+        }
+    }
+    _journal_count = 0;
+    while (_journal_count < kJournalSlots) {
+        const Record &record = journal()[_journal_count];
+        if (!check_record(record, _generation)) {
+            break;
+        }
+        _values[std::string(record.key, record.key_size)] =
+            std::string(record.value, record.value_size);
+        _journal_count++;
+    }
+    _sync_begin = _journal_count;
+    return true;
+}
+
+}  // namespace mavcam
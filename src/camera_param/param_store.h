@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+
+namespace mavcam {
+
+/**
+ * @brief Memory-mapped key value store for camera parameters
+ * @details The file has a fixed layout:
+ *
+ *   header   : magic, generation, slot counts, header crc
+ *   snapshot : kSnapshotSlots records, written as a whole by compaction
+ *   journal  : kJournalSlots records, each change appends one record
+ *
+ * Every record carries a CRC-32 over its content and the file generation, replay stops at the
+ * first journal record that does not match, so a torn append or a stale record of an older
+ * generation is ignored. Compaction merges the journal into a new snapshot and replaces the
+ * file atomically. Not thread safe, the owner serializes access.
+ */
+class ParamStore final {
+public:
+    static constexpr size_t kMaxKeySize = 24;
+    static constexpr size_t kMaxValueSize = 32;
+    static constexpr size_t kSnapshotSlots = 64;
+    static constexpr size_t kJournalSlots = 256;
+public:
+    ParamStore();
+    ~ParamStore();
+public:
+    /**
+     * @brief map the store file, create an empty one when missing or corrupted
+     */
+    bool open(const std::string &path);
+    void close();
+    bool get(const std::string &key, std::string &value) const;
+    /**
+     * @brief update one value, appends a record to journal or compacts when journal is full
+     * @details the value is kept in memory only when it reached the file
+     */
+    bool set(const std::string &key, const std::string &value);
+    /**
+     * @brief write dirty journal pages to storage
+     */
+    bool sync();
+    /**
+     * @brief merge journal into snapshot and replace the file
+     */
+    bool compact();
+    size_t journal_size() const { return _journal_count; }
+    const std::map<std::string, std::string> &values() const { return _values; }
+private:
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t generation;
+        uint32_t snapshot_slots;
+        uint32_t journal_slots;
+        uint32_t record_size;
+        uint32_t reserved[8];
+        uint32_t crc;
+    };
+
+    struct Record {
+        uint32_t crc;
+        uint8_t key_size;
+        uint8_t value_size;
+        uint16_t reserved;
+        char key[kMaxKeySize];
+        char value[kMaxValueSize];
+    };
+private:
+    bool map_file();
+    void unmap_file();
+    bool load();
+    bool write_file(uint32_t generation);
+    Record *snapshot() const;
+    Record *journal() const;
+    static bool fill_record(Record &record, const std::string &key, const std::string &value,
+                            uint32_t generation);
+    static bool check_record(const Record &record, uint32_t generation);
+    static uint32_t record_crc(const Record &record, uint32_t generation);
+    static size_t file_size();
+private:
+    std::string _path{};
+    int _fd{-1};
+    char *_data{nullptr};
+    uint32_t _generation{0};
+    size_t _journal_count{0};
+    size_t _sync_begin{0};  ///< first journal slot not synced yet
+    std::map<std::string, std::string> _values{};
+};
+
+}  // namespace mavcam
@@ -1,27 +1,190 @@
 #include "led_control.h"
 
-#include <cstdlib>  // for std::system
-#include <string>
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+
+#include "base/log.h"
 
 namespace mavcam {
 
-void switch_led_mode(LedMode mode) {
-    std::string command;
-    if (mode == LedMode::Normal) {
-        command = "leds-mode --combination 8";
-        printf("switch to normal\n");
-    } else if (mode == LedMode::Dead) {
-        command = "leds-mode --combination 1";
-    } else if (mode == LedMode::SDCardError) {
-        command = "leds-mode --combination 4 --blink";
-    } else if (mode == LedMode::Recording) {
-        command = "leds-mode --combination 9";
-    } else if (mode == LedMode::TakePhoto) {
-        command = "leds-mode --combination 10";
+static const char *kDefaultRootPath = "/sys/class/leds";
+// bit i of a combination, counted the same way as the leds-mode tool did
+static const char *kLedNames[] = {"led1", "led2", "led3", "led4"};
+static constexpr auto kPhotoFlash = std::chrono::milliseconds(300);
+static constexpr auto kBlinkInterval = std::chrono::milliseconds(500);
+
+LedControl &LedControl::instance() {
+    static LedControl control;
+    return control;
+}
+
+LedControl::LedControl() {
+    const char *root_path = getenv("MAVCAM_LED_ROOT");
+    _root_path = root_path != nullptr ? root_path : kDefaultRootPath;
+}
+
+LedControl::~LedControl() {
+    stop();
+}
+
+void LedControl::set_root_path(const std::string &path) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _root_path = path;
+        _root_changed = true;
+    }
+    _cv.notify_one();
+}
+
+void LedControl::switch_mode(LedMode mode) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_should_exit) {
+            return;
+        }
+        switch (mode) {
+            case LedMode::Normal:
+                _sdcard_error = false;
+                _recording = false;
+                break;
+            case LedMode::Dead:
+                _dead = true;
+                break;
+            case LedMode::SDCardError:
+                _sdcard_error = true;
+                break;
+            case LedMode::Recording:
+                _recording = true;
+                break;
+            case LedMode::TakePhoto:
+                _photo_until = std::chrono::steady_clock::now() + kPhotoFlash;
+                break;
+        }
+        _rewrite = true;
+        if (_work_thread == nullptr) {
+            _work_thread = new std::thread(work_thread, this);
+        }
+    }
+    _cv.notify_one();
+}
+
+void LedControl::stop() {
+    std::thread *thread = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _should_exit = true;
+        thread = _work_thread;
+        _work_thread = nullptr;
+    }
+    _cv.notify_one();
+    if (thread != nullptr) {
+        thread->join();
+        delete thread;
+    }
+}
+
+LedControl::Pattern LedControl::current_pattern_locked(
+    std::chrono::steady_clock::time_point now) const {
+    if (_dead) {
+        return Pattern{1, false};
     }
-    if (!command.empty()) {
-        std::system(command.c_str());
+    if (_sdcard_error) {
+        return Pattern{4, true};
     }
+    if (now < _photo_until) {
+        return Pattern{10, false};
+    }
+    if (_recording) {
+        return Pattern{9, false};
+    }
+    return Pattern{8, false};
+}
+
+void LedControl::release_triggers(const std::string &root) {
+    // a kernel trigger would fight over brightness with the worker
+    for (const char *led : kLedNames) {
+        write_led_file(root, led, "trigger", "none");
+    }
+}
+
+void LedControl::write_leds(const std::string &root, int combination) {
+    for (size_t i = 0; i < sizeof(kLedNames) / sizeof(kLedNames[0]); i++) {
+        std::string value = "0";
+        if (combination & (1 << i)) {
+            std::ifstream max_file(root + "/" + kLedNames[i] + "/max_brightness");
+            if (!(max_file >> value)) {
+                value = "1";
+            }
+        }
+        write_led_file(root, kLedNames[i], "brightness", value);
+    }
+}
+
+bool LedControl::write_led_file(const std::string &root, const char *led, const char *file,
+                                const std::string &value) {
+    std::string path = root + "/" + led + "/" + file;
+    std::ofstream out(path, std::ios::trunc);
+    out << value;
+    out.flush();
+    if (!out) {
+        base::LogWarn() << "Cannot write " << value << " to " << path;
+        return false;
+    }
+    return true;
+}
+
+void LedControl::work_thread(LedControl *self) {
+    std::unique_lock<std::mutex> lock(self->_mutex);
+    int shown = -1;
+    bool blink_on = true;
+    auto next_toggle = std::chrono::steady_clock::now();
+    while (!self->_should_exit) {
+        auto now = std::chrono::steady_clock::now();
+        auto deadline = std::chrono::steady_clock::time_point::max();
+        Pattern pattern = self->current_pattern_locked(now);
+        if (pattern.blink) {
+            if (now >= next_toggle) {
+                blink_on = !blink_on;
+                next_toggle = now + kBlinkInterval;
+            }
+            deadline = next_toggle;
+        } else {
+            // a blinking pattern starts lit
+            blink_on = true;
+            next_toggle = now + kBlinkInterval;
+        }
+        if (now < self->_photo_until) {
+            deadline = std::min(deadline, self->_photo_until);
+        }
+
+        int combination = blink_on ? pattern.combination : 0;
+        if (self->_root_changed || self->_rewrite || combination != shown) {
+            bool release = self->_root_changed;
+            self->_root_changed = false;
+            self->_rewrite = false;
+            std::string root = self->_root_path;
+            lock.unlock();
+            if (release) {
+                release_triggers(root);
+            }
+            write_leds(root, combination);
+            lock.lock();
+            shown = combination;
+            // requests may have come in while writing
+            continue;
+        }
+
+        if (deadline == std::chrono::steady_clock::time_point::max()) {
+            self->_cv.wait(lock);
+        } else {
+            self->_cv.wait_until(lock, deadline);
+        }
+    }
+}
+
+void switch_led_mode(LedMode mode) {
+    LedControl::instance().switch_mode(mode);
 }
 
-}  // namespace mavcam
\ No newline at end of file
+}  // namespace mavcam
@@ -1,5 +1,11 @@
 #pragma once
 
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
 namespace mavcam {
 
 enum class LedMode {
@@ -10,6 +16,60 @@ enum class LedMode {
     TakePhoto,    ///< take photo
 };
 
+/**
+ * @brief Drives the LEDs through the sysfs led class
+ * @details Callers only record the requested mode, a worker thread owns the LEDs and writes
+ * brightness files when the shown pattern changes. Modes are layered by priority: Dead is kept
+ * until exit, SDCardError until Normal is requested, TakePhoto flashes shortly over Recording or
+ * Normal. The worker also toggles blinking patterns, so no kernel trigger is needed.
+ */
+class LedControl final {
+public:
+    static LedControl &instance();
+    ~LedControl();
+public:
+    /**
+     * @brief directory holding one folder per LED, default is $MAVCAM_LED_ROOT or /sys/class/leds
+     */
+    void set_root_path(const std::string &path);
+    /**
+     * @brief request a mode, returns without touching the LEDs
+     */
+    void switch_mode(LedMode mode);
+    /**
+     * @brief stop worker thread, the LEDs keep the last pattern
+     */
+    void stop();
+private:
+    struct Pattern {
+        int combination{0};  ///< bit i lights kLedNames[i]
+        bool blink{false};
+    };
+private:
+    LedControl();
+    Pattern current_pattern_locked(std::chrono::steady_clock::time_point now) const;
+    static void release_triggers(const std::string &root);
+    static void write_leds(const std::string &root, int combination);
+    static bool write_led_file(const std::string &root, const char *led, const char *file,
+                               const std::string &value);
+    static void work_thread(LedControl *self);
+private:
+    std::mutex _mutex{};
+    std::condition_variable _cv{};
+    std::thread *_work_thread{nullptr};
+    bool _should_exit{false};
+    std::string _root_path{};
+    bool _root_changed{true};  ///< triggers are released again on next write
+    bool _rewrite{false};      ///< another process may have written the LEDs since
+    bool _dead{false};
+    bool _sdcard_error{false};
+    bool _recording{false};
+    std::chrono::steady_clock::time_point _photo_until{};
+};
+
+/**
+ * @brief request a mode from LedControl
+ */
 void switch_led_mode(LedMode mode);
 
-}  // namespace mavcam
\ No newline at end of file
+}  // namespace mavcam
@@ -38,6 +38,12 @@ public:  // settings
     virtual mavsdk::CameraServer::Result retrieve_current_settings(
         std::vector<mavsdk::Camera::Setting> &settings) = 0;
     virtual mavsdk::CameraServer::Result set_setting(mavsdk::Camera::Setting setting) = 0;
+    /**
+     * @brief change several settings in one operation
+     * @details all settings are validated first, either all of them are applied or none
+     */
+    virtual mavsdk::CameraServer::Result set_settings(
+        std::vector<mavsdk::Camera::Setting> settings) = 0;
     virtual std::pair<mavsdk::CameraServer::Result, mavsdk::Camera::Setting> get_setting(
         mavsdk::Camera::Setting setting) const = 0;
 };
@@ -4,33 +4,20 @@
 #include <string.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <iomanip>  // for std::setprecision
 #include <regex>
 #include <thread>
 
 #include "base/log.h"
+#include "base/startup_profiler.h"
 #include "led_control/led_control.h"
 
 namespace mavcam {
 
-const std::string kCameraModeName = "CAM_MODE";
-const std::string kCameraDisplayModeName = "CAM_DIS_MODE";
-const std::string kPhotoResolution = "CAM_PHOTO_RES";
-const std::string kPhotoQuality = "CAM_PHOTO_QC";
-const std::string kVideoResolution = "CAM_VIDRES";
-const std::string kVideoFormat = "CAM_VIDFMT";
-const std::string kWhitebalanceModeName = "CAM_WBMODE";
-const std::string kExposureMode = "CAM_EXPMODE";
-const std::string kEVName = "CAM_EV";
-const std::string kISOName = "CAM_ISO";
-const std::string kShutterSpeedName = "CAM_SHUTTERSPD";
-const std::string kMeteringModeName = "CAM_METER";
-const std::string kSharpnessName = "CAM_SHARPNESS";
-const std::string kAELockName = "CAM_AE_LOCK";
-
-const std::string kIrCamPalette = "IRCAM_PALETTE";
-const std::string kIrCamFFC = "IRCAM_FFC";
+using settings::SettingId;
 
 static const int32_t kPreviewWidth = 1920;
 static const int32_t kPreviewPhotoHeight = 1440;
@@ -50,6 +37,29 @@ static const int32_t kSDCardMinAvaliableMB = 200;  ///< min sdcard avaiable MB
 
 typedef mav_camera::MavCamera *(*create_qcom_camera_fun)();
 
+static bool video_format(const std::string &value, int &width, int &height, int &framerate) {
+    if (value == "0") {
+        width = 3840;
+        height = 2160;
+        framerate = 60;
+    } else if (value == "1") {
+        width = 3840;
+        height = 2160;
+        framerate = 30;
+    } else if (value == "2") {
+        width = 1920;
+        height = 1080;
+        framerate = 60;
+    } else if (value == "3") {
+        width = 1920;
+        height = 1080;
+        framerate = 30;
+    } else {
+        return false;
+    }
+    return true;
+}
+
 CameraLocalClient::CameraLocalClient() {
     _current_mode = mavsdk::CameraServer::Mode::Unknown;
     _framerate = 30;
@@ -158,8 +168,7 @@ mavsdk::CameraServer::Result CameraLocalClient::set_mode(mavsdk::CameraServer::M
         setting_mode = "1";
     }
     // use set setting to change camera mode
-    auto setting = build_setting(kCameraModeName, setting_mode);
-    return set_setting(setting);
+    return apply_settings({build_setting(SettingId::CamMode, setting_mode)});
 }
 
 mavsdk::CameraServer::Result CameraLocalClient::format_storage(int storage_id) {
@@ -185,34 +194,27 @@ mavsdk::CameraServer::Result CameraLocalClient::reset_settings() {
     }
     std::lock_guard<std::mutex> lock(_mutex);
 
+    // values stored as params, written at once after both cameras are reset
+    std::vector<std::pair<std::string, std::string>> values;
+
     // reset RGB camera settings
     base::LogDebug() << "reset rgb camera";
     auto result = _mav_camera->reset_settings();
     if (result == mav_camera::Result::Success) {
         // reset settings value
-        _settings[kCameraModeName] = "0";
-        _camera_param.set_value(kCameraModeName, "0");
-        _settings[kCameraDisplayModeName] = "3";
-        _camera_param.set_value(kCameraDisplayModeName, "3");
-        _settings[kPhotoQuality] = "0";
-        _camera_param.set_value(kPhotoQuality, "0");
-        _settings[kWhitebalanceModeName] = "0";
-        _camera_param.set_value(kWhitebalanceModeName, "0");
-        _settings[kExposureMode] = "0";
-        _camera_param.set_value(kExposureMode, "0");
-        _settings[kEVName] = "0";
-        _camera_param.set_value(kEVName, "0");
-        _settings[kISOName] = "125";
-        _camera_param.set_value(kISOName, "125");
-        _settings[kShutterSpeedName] = "0.01";
-        _camera_param.set_value(kShutterSpeedName, "0.01");
-        _settings[kVideoFormat] = "1";
-        _camera_param.set_value(kVideoFormat, "1");
-        _settings[kMeteringModeName] = "0";
-        _camera_param.set_value(kMeteringModeName, "0");
-        _settings[kSharpnessName] = "0";
-        _camera_param.set_value(kSharpnessName, "0");
-        _settings[kAELockName] = "0";  // ae lock don't store to param
+        static const std::pair<SettingId, const char *> kDefaults[] = {
+            {SettingId::CamMode, "0"},    {SettingId::CamDisMode, "3"},
+            {SettingId::CamPhotoQc, "0"}, {SettingId::CamWbmode, "0"},
+            {SettingId::CamExpmode, "0"}, {SettingId::CamEv, "0"},
+            {SettingId::CamIso, "125"},   {SettingId::CamShutterspd, "0.01"},
+            {SettingId::CamVidfmt, "1"},  {SettingId::CamMeter, "0"},
+            {SettingId::CamSharpness, "0"},
+        };
+        for (const auto &[id, value] : kDefaults) {
+            update_setting(id, value);
+            values.emplace_back(settings::setting_name(id), value);
+        }
+        update_setting(SettingId::CamAeLock, "0");  // ae lock don't store to param
     }
 
     //reset ir camera settings
@@ -220,11 +222,14 @@ mavsdk::CameraServer::Result CameraLocalClient::reset_settings() {
     const std::string default_palette = "2";
     bool ret = set_ir_palette(default_palette);  // default is rainbow
     if (ret) {
-        _settings[kIrCamPalette] = default_palette;
-        _camera_param.set_value(kIrCamPalette, default_palette);
-        _settings[kIrCamFFC] = "0";
+        update_setting(SettingId::IrcamPalette, default_palette);
+        values.emplace_back(settings::setting_name(SettingId::IrcamPalette), default_palette);
+        update_setting(SettingId::IrcamFfc, "0");
     }
 
+    if (!values.empty()) {
+        _camera_param.set_values(values);
+    }
     return mavsdk::CameraServer::Result::Success;
 }
 
@@ -265,7 +270,7 @@ mavsdk::CameraServer::Result CameraLocalClient::fill_information(
         information.vertical_resolution_px = in_info.vertical_resolution_px;
         information.lens_id = in_info.lens_id;
         //TODO (Thomas) : hard code
-        information.definition_file_version = 12;
+        information.definition_file_version = settings::kDefinitionVersion;
         information.definition_file_uri = "mftp://definition/D64TR.xml";
 
     } else {
@@ -398,7 +403,8 @@ mavsdk::CameraServer::Result CameraLocalClient::fill_capture_status(
 mavsdk::CameraServer::Result CameraLocalClient::fill_settings(
     mavsdk::CameraServer::Settings &settings) {
     base::LogDebug() << "locally call fill settings ";
-    if (_settings[kCameraModeName] == "0") {
+    std::lock_guard<std::mutex> lock(_settings_mutex);
+    if (_settings[SettingId::CamMode] == "0") {
         settings.mode = mavsdk::CameraServer::Mode::Photo;
     } else {
         settings.mode = mavsdk::CameraServer::Mode::Video;
@@ -411,103 +417,189 @@ mavsdk::CameraServer::Result CameraLocalClient::fill_settings(
 mavsdk::CameraServer::Result CameraLocalClient::retrieve_current_settings(
     std::vector<mavsdk::Camera::Setting> &settings) {
     settings.clear();
-    for (auto &it : _settings) {
-        settings.emplace_back(build_setting(it.first, it.second));
+    std::lock_guard<std::mutex> lock(_settings_mutex);
+    for (const auto &info : settings::kSettings) {
+        if (_settings.contains(info.id)) {
+            settings.emplace_back(build_setting(info.id, _settings[info.id]));
+        }
     }
 
     return mavsdk::CameraServer::Result::Success;
 }
 
 mavsdk::CameraServer::Result CameraLocalClient::set_setting(mavsdk::Camera::Setting setting) {
+    return set_settings({setting});
+}
+
+mavsdk::CameraServer::Result CameraLocalClient::set_settings(
+    std::vector<mavsdk::Camera::Setting> settings) {
     if (_mav_camera == nullptr) {
         return mavsdk::CameraServer::Result::NoSystem;
     }
-    base::LogDebug() << "change " << setting.setting_id << " to " << setting.option.option_id;
-    if (_settings.count(setting.setting_id) == 0) {
-        base::LogError() << "Unsupport setting " << setting.setting_id;
-        return mavsdk::CameraServer::Result::WrongArgument;
+    std::lock_guard<std::mutex> lock(_mutex);
+    return apply_settings(settings);
+}
+
+mavsdk::CameraServer::Result CameraLocalClient::apply_settings(
+    const std::vector<mavsdk::Camera::Setting> &settings) {
+    // validate everything before the camera is touched, a later value of a setting wins
+    settings::SettingValues requested;
+    for (const auto &setting : settings) {
+        base::LogDebug() << "change " << setting.setting_id << " to " << setting.option.option_id;
+        SettingId id;
+        if (!settings::find_setting(setting.setting_id, id) || !_settings.contains(id)) {
+            base::LogError() << "Unsupport setting " << setting.setting_id;
+            return mavsdk::CameraServer::Result::WrongArgument;
+        }
+        if (!is_valid_value(id, setting.option.option_id)) {
+            base::LogError() << "Invalid value " << setting.option.option_id << " for "
+                             << setting.setting_id;
+            return mavsdk::CameraServer::Result::WrongArgument;
+        }
+        requested[id] = setting.option.option_id;
     }
-    bool set_success = false;
-    if (setting.setting_id == kCameraModeName) {
-        mav_camera::Mode set_mode = mav_camera::Mode::Unknown;
-        if (setting.option.option_id == "0") {
-            set_mode = mav_camera::Mode::Photo;
-        } else {
-            set_mode = mav_camera::Mode::Video;
+
+    // apply in definition order, so camera mode goes before the settings depending on it
+    std::vector<std::pair<SettingId, std::string>> applied;  ///< id and value before the call
+    for (const auto &info : settings::kSettings) {
+        const std::string &value = requested[info.id];
+        // ffc is an action, it runs every time it is requested and cannot be undone
+        bool is_action = info.id == SettingId::IrcamFfc;
+        if (value.empty() || (value == _settings[info.id] && !is_action)) {
+            continue;
         }
-        auto result = _mav_camera->set_mode(set_mode);
-        set_success = result == mav_camera::Result::Success;
-        if (set_success) {
-            if (set_mode == mav_camera::Mode::Photo) {
-                _current_mode = mavsdk::CameraServer::Mode::Photo;
-            } else {
-                _current_mode = mavsdk::CameraServer::Mode::Video;
+        if (!apply_setting(info.id, value)) {
+            base::LogError() << "Failed to set " << info.name << " to " << value;
+            // restore what this call changed, in reverse order
+            for (auto it = applied.rbegin(); it != applied.rend(); it++) {
+                if (it->first == SettingId::IrcamFfc) {
+                    continue;
+                }
+                if (apply_setting(it->first, it->second)) {
+                    update_setting(it->first, it->second);
+                } else {
+                    base::LogError() << "Failed to restore " << settings::setting_name(it->first);
+                }
             }
+            return mavsdk::CameraServer::Result::Error;
         }
-    } else if (setting.setting_id == kCameraDisplayModeName) {
-        set_success = set_camera_display_mode(setting.option.option_id);
-    } else if (setting.setting_id == kPhotoResolution) {
-        if (setting.option.option_id == "0") {
-            auto result = _mav_camera->set_snapshot_resolution(kSnapshotWidth, kSnapshotHeight);
-            set_success = result == mav_camera::Result::Success;
-        } else if (setting.option.option_id == "1") {
-            auto result =
-                _mav_camera->set_snapshot_resolution(kSnapshotHalfWidth, kSnapshotHalfHeight);
+        applied.emplace_back(info.id, _settings[info.id]);
+        update_setting(info.id, value);
+    }
+
+    // store all changed values at once
+    std::vector<std::pair<std::string, std::string>> values;
+    for (const auto &[id, old_value] : applied) {
+        values.emplace_back(settings::setting_name(id), _settings[id]);
+    }
+    _camera_param.set_values(values);
+    return mavsdk::CameraServer::Result::Success;
+}
+
+bool CameraLocalClient::apply_setting(SettingId id, const std::string &value) {
+    bool set_success = false;
+    switch (id) {
+        case SettingId::CamMode: {
+            mav_camera::Mode set_mode = mav_camera::Mode::Unknown;
+            if (value == "0") {
+                set_mode = mav_camera::Mode::Photo;
+            } else {
+                set_mode = mav_camera::Mode::Video;
+            }
+            auto result = _mav_camera->set_mode(set_mode);
             set_success = result == mav_camera::Result::Success;
+            if (set_success) {
+                if (set_mode == mav_camera::Mode::Photo) {
+                    _current_mode = mavsdk::CameraServer::Mode::Photo;
+                } else {
+                    _current_mode = mavsdk::CameraServer::Mode::Video;
+                }
+            }
+            break;
         }
-    } else if (setting.setting_id == kPhotoQuality) {
-        mav_camera::JpegQuality jpeg_quality;
-        if (setting.option.option_id == "0") {
-            jpeg_quality = mav_camera::JpegQuality::SuperFine;
-        } else if (setting.option.option_id == "1") {
-            jpeg_quality = mav_camera::JpegQuality::Fine;
-        } else if (setting.option.option_id == "2") {
-            jpeg_quality = mav_camera::JpegQuality::Normal;
+        case SettingId::CamDisMode:
+            set_success = set_camera_display_mode(value);
+            break;
+        case SettingId::CamPhotoRes:
+            if (value == "0") {
+                auto result =
+                    _mav_camera->set_snapshot_resolution(kSnapshotWidth, kSnapshotHeight);
+                set_success = result == mav_camera::Result::Success;
+            } else if (value == "1") {
+                auto result =
+                    _mav_camera->set_snapshot_resolution(kSnapshotHalfWidth, kSnapshotHalfHeight);
+                set_success = result == mav_camera::Result::Success;
+            }
+            break;
+        case SettingId::CamPhotoQc: {
+            mav_camera::JpegQuality jpeg_quality;
+            if (value == "0") {
+                jpeg_quality = mav_camera::JpegQuality::SuperFine;
+            } else if (value == "1") {
+                jpeg_quality = mav_camera::JpegQuality::Fine;
+            } else if (value == "2") {
+                jpeg_quality = mav_camera::JpegQuality::Normal;
+            }
+            auto result = _mav_camera->set_jpeg_quality(jpeg_quality);
+            set_success = result == mav_camera::Result::Success;
+            break;
         }
-        auto result = _mav_camera->set_jpeg_quality(jpeg_quality);
-        set_success = result == mav_camera::Result::Success;
-    } else if (setting.setting_id == kWhitebalanceModeName) {  // whitebalance mode
-        set_success = set_whitebalance_mode(setting.option.option_id);
-    } else if (setting.setting_id == kExposureMode) {
-        set_success = set_exposure_mode(setting.option.option_id);
-    } else if (setting.setting_id == kEVName) {  // exposure value
-        set_success = set_exposure_value(setting.option.option_id);
-    } else if (setting.setting_id == kISOName) {
-        set_success = set_iso(setting.option.option_id);
-    } else if (setting.setting_id == kShutterSpeedName) {
-        set_success = set_shutter_speed(setting.option.option_id);
-    } else if (setting.setting_id == kVideoResolution) {
-        set_success = set_video_resolution(setting.option.option_id);
-    } else if (setting.setting_id == kMeteringModeName) {
-        set_success = set_metering_mode(setting.option.option_id);
-    } else if (setting.setting_id == kSharpnessName) {
-        set_success = set_sharpness(setting.option.option_id);
-    } else if (setting.setting_id == kAELockName) {
-        set_success = set_ae_lock(setting.option.option_id);
-    } else if (setting.setting_id == kIrCamPalette) {
-        set_success = set_ir_palette(setting.option.option_id);
-    } else if (setting.setting_id == kIrCamFFC) {
-        set_success = set_ir_FFC(setting.option.option_id);
-    } else {
-        base::LogError() << "Not implement setting" << setting.setting_id;
-        set_success = false;
+        case SettingId::CamWbmode:  // whitebalance mode
+            set_success = set_whitebalance_mode(value);
+            break;
+        case SettingId::CamExpmode:
+            set_success = set_exposure_mode(value);
+            break;
+        case SettingId::CamEv:  // exposure value
+            set_success = set_exposure_value(value);
+            break;
+        case SettingId::CamIso:
+            set_success = set_iso(value);
+            break;
+        case SettingId::CamShutterspd:
+            set_success = set_shutter_speed(value);
+            break;
+        case SettingId::CamVidres:
+            set_success = set_video_resolution(value);
+            break;
+        case SettingId::CamMeter:
+            set_success = set_metering_mode(value);
+            break;
+        case SettingId::CamSharpness:
+            set_success = set_sharpness(value);
+            break;
+        case SettingId::CamAeLock:
+            set_success = set_ae_lock(value);
+            break;
+        case SettingId::IrcamPalette:
+            set_success = set_ir_palette(value);
+            break;
+        case SettingId::IrcamFfc:
+            set_success = set_ir_FFC(value);
+            break;
+        default:
+            base::LogError() << "Not implement setting" << settings::setting_name(id);
+            set_success = false;
+            break;
     }
 
-    // when set success update the settings value and store value
-    if (set_success) {
-        _settings[setting.setting_id] = setting.option.option_id;
-        _camera_param.set_value(setting.setting_id, setting.option.option_id);
-    }
-    return mavsdk::CameraServer::Result::Success;
+    return set_success;
 }
 
 std::pair<mavsdk::CameraServer::Result, mavsdk::Camera::Setting> CameraLocalClient::get_setting(
     mavsdk::Camera::Setting setting) const {
     base::LogDebug() << "call get_setting " << setting.setting_id;
-    if (_settings.count(setting.setting_id) == 0) {
+    SettingId id;
+    if (!settings::find_setting(setting.setting_id, id)) {
         return {mavsdk::CameraServer::Result::WrongArgument, setting};
     }
-    setting.option.option_id = _settings[setting.setting_id];
+    {
+        std::lock_guard<std::mutex> lock(_settings_mutex);
+        if (!_settings.contains(id)) {
+            return {mavsdk::CameraServer::Result::WrongArgument, setting};
+        }
+        setting.option.option_id = _settings[id];
+    }
     base::LogDebug() << "get " << setting.setting_id << " return " << setting.option.option_id;
     return {mavsdk::CameraServer::Result::Success, setting};
 }
@@ -517,11 +609,18 @@ bool CameraLocalClient::init() {
         return true;
     }
 
-    //init ir camera first for ir stream function
-    auto ir_result = init_ir_camera();
-    _settings[kIrCamPalette] = init_ir_palette();
-    _settings[kIrCamFFC] = "0";
+    InitStats init_stats;
+    // ir camera is an independent device, bring it up while rgb camera opens, its settings are
+    // listed right away and applied once it is ready
+    auto store_ir_palette = load_param(SettingId::IrcamPalette);
+    update_setting(SettingId::IrcamPalette,
+                   store_ir_palette.empty()
+                       ? settings::setting_info(SettingId::IrcamPalette).default_value
+                       : store_ir_palette);
+    update_setting(SettingId::IrcamFfc, "0");
+    _ir_init_thread = new std::thread(ir_init_thread, this);
 
+    base::StartupPhase dlopen_phase("qcom_dlopen");
     _plugin_handle = dlopen(QCOM_CAMERA_LIBERAY, RTLD_NOW);
     if (_plugin_handle == NULL) {
         char const *err_str = dlerror();
@@ -547,8 +646,12 @@ bool CameraLocalClient::init() {
         return false;
     }
 
+    dlopen_phase.stop();
+
     _mav_camera->set_log_path("/data/camera/qcom_cam.log");
+    base::StartupPhase prepare_phase("qcom_prepare");
     mav_camera::Result result = _mav_camera->prepare();
+    prepare_phase.stop();
     if (result != mav_camera::Result::Success) {
         base::LogDebug() << "cannot find qcom camera";
         return false;
@@ -574,12 +677,12 @@ bool CameraLocalClient::init() {
         }
     }
 
-    auto store_mode = _camera_param.get_value(kCameraModeName);
+    auto store_mode = load_param(SettingId::CamMode);
     if (store_mode.empty()) {  // init default param to local storage
         if (camera_mode == mav_camera::Mode::Photo) {
-            _camera_param.set_value(kCameraModeName, "0");
+            store_param(SettingId::CamMode, "0");
         } else {
-            _camera_param.set_value(kCameraModeName, "1");
+            store_param(SettingId::CamMode, "1");
         }
     } else {
         if (store_mode == "0") {
@@ -591,9 +694,9 @@ bool CameraLocalClient::init() {
 
     options.init_mode = camera_mode;
     if (options.init_mode == mav_camera::Mode::Photo) {
-        _settings[kCameraModeName] = "0";
+        update_setting(SettingId::CamMode, "0");
     } else {
-        _settings[kCameraModeName] = "1";
+        update_setting(SettingId::CamMode, "1");
     }
 
     /************** Photo Resolution *************/
@@ -613,7 +716,7 @@ bool CameraLocalClient::init() {
             // for manually set snapshot resolution, not use half snapshot resolution
             options.snapshot_width = kSnapshotWidth;
             options.snapshot_height = kSnapshotHeight;
-            _settings[kPhotoResolution] = "0";
+            update_setting(SettingId::CamPhotoRes, "0");
         }
     } else {
         int32_t snapshot_width = 0;
@@ -622,34 +725,34 @@ bool CameraLocalClient::init() {
         kSnapshotHalfWidth = kSnapshotWidth / 2;
         kSnapshotHalfHeight = kSnapshotHeight / 2;
 
-        auto store_resolution = _camera_param.get_value(kPhotoResolution);
+        auto store_resolution = load_param(SettingId::CamPhotoRes);
         if (store_resolution.empty()) {  // init default param to local storage
             // default is full resolution
             options.snapshot_width = kSnapshotWidth;
             options.snapshot_height = kSnapshotHeight;
-            _settings[kPhotoResolution] = "0";
-            _camera_param.set_value(kPhotoResolution, "0");
+            update_setting(SettingId::CamPhotoRes, "0");
+            store_param(SettingId::CamPhotoRes, "0");
         } else {
             if (store_resolution == "0") {
                 options.snapshot_width = kSnapshotWidth;
                 options.snapshot_height = kSnapshotHeight;
-                _settings[kPhotoResolution] = "0";  // 0 for full resolution
+                update_setting(SettingId::CamPhotoRes, "0");  // 0 for full resolution
             } else {
                 options.snapshot_width = kSnapshotHalfWidth;
                 options.snapshot_height = kSnapshotHeight;
-                _settings[kPhotoResolution] = "1";  // 1 for 1/4 resolution
+                update_setting(SettingId::CamPhotoRes, "1");  // 1 for 1/4 resolution
             }
         }
     }
 
     /************** Jpeg Quality *************/
-    auto store_jpeg_quality = _camera_param.get_value(kPhotoQuality);
+    auto store_jpeg_quality = load_param(SettingId::CamPhotoQc);
     if (store_jpeg_quality.empty()) {
         options.jpeg_quality = mav_camera::JpegQuality::SuperFine;
-        _settings[kPhotoQuality] = "0";  // 0 for jpeg super fine
-        _camera_param.set_value(kPhotoQuality, "0");
+        update_setting(SettingId::CamPhotoQc, "0");  // 0 for jpeg super fine
+        store_param(SettingId::CamPhotoQc, "0");
     } else {
-        _settings[kPhotoQuality] = store_jpeg_quality;
+        update_setting(SettingId::CamPhotoQc, store_jpeg_quality);
         if (store_jpeg_quality == "0") {
             options.jpeg_quality = mav_camera::JpegQuality::SuperFine;
         } else if (store_jpeg_quality == "1") {
@@ -667,10 +770,14 @@ bool CameraLocalClient::init() {
         options.preview_height = kPreviewPhotoHeight;
     }
 
+    /************** Video Resolution *************/
+    // open with the stored format, changing it later restarts the video pipeline
     options.video_width = kVideoWidth;
     options.video_height = kVideoHeight;
-
     options.framerate = _framerate;
+    video_format(load_param(SettingId::CamVidres), options.video_width, options.video_height,
+                 options.framerate);
+
     options.debug_calc_fps = false;
 
     const char *store_prefix = getenv("MAVCAM_DEFAULT_STORE_PREFIX");
@@ -681,7 +788,9 @@ bool CameraLocalClient::init() {
         base::LogInfo() << "Set store prefix to " << options.store_prefix;
     }
 
+    base::StartupPhase open_phase("qcom_open");
     result = _mav_camera->open(options);
+    open_phase.stop();
     if (result == mav_camera::Result::Success) {
         base::LogDebug() << "open qcom camera success";
     }
@@ -693,28 +802,51 @@ bool CameraLocalClient::init() {
             check_sdcard_status();
         });
 
-    // init all settings
-    _settings[kCameraDisplayModeName] = init_camera_display_mode();
-    _settings[kWhitebalanceModeName] = init_whitebalance_mode();
-    _settings[kExposureMode] = init_exposure_mode();
-    _settings[kEVName] = init_exposure_value();
-    _settings[kISOName] = init_iso();
-    _settings[kShutterSpeedName] = init_shutter_speed();
-    _settings[kVideoFormat] = init_video_format();
-    _settings[kVideoResolution] = init_video_resolution();
-    _settings[kMeteringModeName] = init_metering_mode();
-    _settings[kSharpnessName] = init_sharpness();
+    // init all settings, only write the stored values the camera does not run with already
+    base::StartupPhase settings_phase("settings_init");
+    settings::SettingValues hardware;
+    read_hardware_settings(hardware);
+    for (auto id : {SettingId::CamDisMode, SettingId::CamWbmode, SettingId::CamExpmode}) {
+        update_setting(id, init_setting(id, hardware[id], true, init_stats));
+    }
+    // exposure value only works in auto exposure mode, iso and shutter speed in manual mode
+    auto excluded = settings::excluded_settings(SettingId::CamExpmode,
+                                                _settings[SettingId::CamExpmode]);
+    for (auto id : {SettingId::CamEv, SettingId::CamIso, SettingId::CamShutterspd}) {
+        bool apply = (excluded & settings::setting_mask(id)) == 0;
+        update_setting(id, init_setting(id, hardware[id], apply, init_stats));
+    }
+    // video format is only used when recording starts
+    update_setting(SettingId::CamVidfmt,
+                   init_setting(SettingId::CamVidfmt, "", false, init_stats));
+    for (auto id : {SettingId::CamVidres, SettingId::CamMeter, SettingId::CamSharpness}) {
+        update_setting(id, init_setting(id, hardware[id], true, init_stats));
+    }
     // always disable ae lock on init
-    _settings[kAELockName] = "0";
-
+    update_setting(SettingId::CamAeLock, "0");
+    base::LogInfo() << "Init settings wrote " << init_stats.applied << " values, skipped "
+                    << init_stats.skipped;
+    settings_phase.stop();
+
+    base::log::RateLimitExemptScope exempt;
+    // ir init thread may write its palette meanwhile
+    std::lock_guard<std::mutex> lock(_settings_mutex);
     base::LogDebug() << "Init settings :";
-    for (const auto &setting : _settings) {
-        base::LogDebug() << "  - " << setting.first << " : " << setting.second;
+    for (const auto &info : settings::kSettings) {
+        if (_settings.contains(info.id)) {
+            base::LogDebug() << "  - " << info.name << " : " << _settings[info.id];
+        }
     }
     return true;
 }
 
 void CameraLocalClient::deinit() {
+    if (_ir_init_thread != nullptr) {
+        _ir_init_thread->join();
+        delete _ir_init_thread;
+        _ir_init_thread = nullptr;
+    }
+    _camera_param.flush();
     if (_mav_camera != nullptr) {
         _mav_camera->close();
         delete _mav_camera;
@@ -728,36 +860,167 @@ void CameraLocalClient::deinit() {
     free_ir_camera();
 }
 
-std::string CameraLocalClient::init_camera_display_mode() {
-    auto store_display_mode = _camera_param.get_value(kCameraDisplayModeName);
-    if (store_display_mode.empty()) {
-        //init default display mode
-        mav_camera::Result result;
-        mav_camera::PreivewStreamOutputType preview_type;
-        std::tie(result, preview_type) = _mav_camera->get_preview_stream_output_type();
-        std::string default_mode = "0";
-        if (result == mav_camera::Result::Success) {
-            switch (preview_type) {
-                case mav_camera::PreivewStreamOutputType::RGBStreamOnly:
-                    default_mode = "0";
-                    break;
-                case mav_camera::PreivewStreamOutputType::InfraredStreamOnly:
-                    default_mode = "1";
-                    break;
-                case mav_camera::PreivewStreamOutputType::MixSideBySide:
-                    default_mode = "2";
-                    break;
-                case mav_camera::PreivewStreamOutputType::MixPIP:
-                    default_mode = "3";
-                    break;
-            }
+std::string CameraLocalClient::init_setting(SettingId id, const std::string &hardware, bool apply,
+                                            InitStats &stats) {
+    auto stored = load_param(id);
+    if (stored.empty()) {
+        // keep what camera runs with, the definition default when it cannot be read
+        std::string value = hardware.empty() ? settings::setting_info(id).default_value : hardware;
+        store_param(id, value);
+        return value;
+    }
+    if (!apply) {
+        return stored;
+    }
+    if (!hardware.empty() && is_same_value(id, hardware, stored)) {
+        stats.skipped++;
+        return stored;
+    }
+    if (!apply_setting(id, stored)) {
+        base::LogError() << "Failed to init " << settings::setting_name(id) << " to " << stored;
+    }
+    stats.applied++;
+    return stored;
+}
+
+void CameraLocalClient::read_hardware_settings(settings::SettingValues &values) {
+    auto [preview_result, preview_type] = _mav_camera->get_preview_stream_output_type();
+    if (preview_result == mav_camera::Result::Success) {
+        switch (preview_type) {
+            case mav_camera::PreivewStreamOutputType::RGBStreamOnly:
+                values[SettingId::CamDisMode] = "0";
+                break;
+            case mav_camera::PreivewStreamOutputType::InfraredStreamOnly:
+                values[SettingId::CamDisMode] = "1";
+                break;
+            case mav_camera::PreivewStreamOutputType::MixSideBySide:
+                values[SettingId::CamDisMode] = "2";
+                break;
+            case mav_camera::PreivewStreamOutputType::MixPIP:
+                values[SettingId::CamDisMode] = "3";
+                break;
+        }
+    }
+
+    auto [wb_result, whitebalance] = _mav_camera->get_white_balance();
+    if (wb_result != mav_camera::Result::Success) {
+        base::LogError() << "Cannot get whitebalance mode"
+                         << convert_camera_result_to_mav_server_result(wb_result);
+    } else if (whitebalance == mav_camera::kAutoWhitebalanceValue) {
+        values[SettingId::CamWbmode] = "0";
+    } else if (whitebalance == 5500) {
+        values[SettingId::CamWbmode] = "1";
+    } else if (whitebalance == 6500) {
+        values[SettingId::CamWbmode] = "2";
+    } else if (whitebalance == 7500) {
+        values[SettingId::CamWbmode] = "3";
+    } else if (whitebalance == 2700) {
+        values[SettingId::CamWbmode] = "4";
+    } else if (whitebalance == 4000) {
+        values[SettingId::CamWbmode] = "5";
+    } else {
+        base::LogWarn() << "invalid white balance value " << whitebalance;
+    }
+
+    auto [ev_result, ev] = _mav_camera->get_exposure_value();
+    if (ev_result != mav_camera::Result::Success) {
+        base::LogError() << "Cannot get exposure value"
+                         << convert_camera_result_to_mav_server_result(ev_result);
+    } else {
+        std::ostringstream oss;
+        oss << std::fixed << std::setprecision(1) << ev;
+        values[SettingId::CamEv] = oss.str();
+    }
+
+    auto [iso_result, iso] = _mav_camera->get_iso();
+    if (iso_result != mav_camera::Result::Success) {
+        base::LogError() << "Cannot get iso value"
+                         << convert_camera_result_to_mav_server_result(iso_result);
+    } else {
+        values[SettingId::CamIso] = std::to_string(iso);
+    }
+
+    auto [shutter_result, shutter_speed] = _mav_camera->get_shutter_speed();
+    if (shutter_result != mav_camera::Result::Success || shutter_speed.empty()) {
+        base::LogDebug() << "Cannot get shutterspeed"
+                         << convert_camera_result_to_mav_server_result(shutter_result);
+    } else {
+        std::size_t pos = shutter_speed.find('/');
+        if (pos != std::string::npos) {
+            // a fraction like "1/100"
+            float numerator = std::stof(shutter_speed.substr(0, pos));
+            float denominator = std::stof(shutter_speed.substr(pos + 1));
+            values[SettingId::CamShutterspd] = std::to_string(numerator / denominator);
+        } else {
+            values[SettingId::CamShutterspd] = shutter_speed;
         }
-        _camera_param.set_value(kCameraDisplayModeName, default_mode);
-        return default_mode;
+    }
+
+    auto [resolution_result, width, height] = _mav_camera->get_video_resolution();
+    auto [framerate_result, framerate] = _mav_camera->get_framerate();
+    if (resolution_result != mav_camera::Result::Success ||
+        framerate_result != mav_camera::Result::Success) {
+        base::LogError() << "Cannot get video resolution";
     } else {
-        set_camera_display_mode(store_display_mode);
-        return store_display_mode;
+        base::LogDebug() << "Current video resolution is " << width << "x" << height << "@"
+                         << framerate;
+        for (auto value : {"0", "1", "2", "3"}) {
+            int format_width = 0;
+            int format_height = 0;
+            int format_framerate = 0;
+            video_format(value, format_width, format_height, format_framerate);
+            if (width == format_width && height == format_height && framerate == format_framerate) {
+                values[SettingId::CamVidres] = value;
+            }
+        }
+    }
+}
+
+void CameraLocalClient::ir_init_thread(CameraLocalClient *self) {
+    base::StartupPhase phase("ir_camera");
+    auto start = std::chrono::steady_clock::now();
+    if (!self->init_ir_camera()) {
+        base::LogError() << "Ir camera is not available";
+        return;
+    }
+    std::lock_guard<std::mutex> lock(self->_mutex);
+    self->_ir_ready.store(true, std::memory_order_release);
+    InitStats init_stats;
+    self->update_setting(SettingId::IrcamPalette,
+                         self->init_setting(SettingId::IrcamPalette, self->read_ir_palette(),
+                                            true, init_stats));
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+    base::LogInfo() << "Ir camera ready in " << duration.count() << " ms";
+}
+
+std::string CameraLocalClient::read_ir_palette() {
+    if (!_ir_ready.load(std::memory_order_acquire)) {
+        return "";
+    }
+    uint32_t color_mode = 0;
+    if (_ir_camera->get(TYPE_CAMERA_COLOR_MODE, &color_mode) != 0) {
+        return "";
     }
+    base::LogDebug() << "Current ir palette is " << int(color_mode);
+    return std::to_string(color_mode);
+}
+
+bool CameraLocalClient::is_same_value(SettingId id, const std::string &lhs,
+                                      const std::string &rhs) {
+    if (settings::setting_info(id).type == settings::SettingType::Int32) {
+        return lhs == rhs;
+    }
+    // float values are formatted differently by camera, param server and definition
+    char *lhs_end = nullptr;
+    char *rhs_end = nullptr;
+    double lhs_number = strtod(lhs.c_str(), &lhs_end);
+    double rhs_number = strtod(rhs.c_str(), &rhs_end);
+    if (*lhs_end != '\0' || *rhs_end != '\0') {
+        return lhs == rhs;
+    }
+    return std::fabs(lhs_number - rhs_number) <=
+           1e-3 * std::max(std::fabs(lhs_number), std::fabs(rhs_number));
 }
 
 bool CameraLocalClient::set_camera_display_mode(std::string mode) {
@@ -788,41 +1051,6 @@ bool CameraLocalClient::set_camera_display_mode(std::string mode) {
     <option name="Cloudy" value="5" />
     <option name="Fluorescent" value="7" />
 */
-std::string CameraLocalClient::init_whitebalance_mode() {
-    auto store_whitebalance = _camera_param.get_value(kWhitebalanceModeName);
-    if (store_whitebalance.empty()) {
-        auto [result, value] = _mav_camera->get_white_balance();
-        std::string whitebalance = "0";
-        if (result != mav_camera::Result::Success) {
-            base::LogError() << "Cannot get whitebalance mode"
-                             << convert_camera_result_to_mav_server_result(result);
-            whitebalance = "0";
-        } else {
-            if (value == mav_camera::kAutoWhitebalanceValue) {
-                whitebalance = "0";
-            } else if (value == 5500) {
-                whitebalance = "1";
-            } else if (value == 6500) {
-                whitebalance = "2";
-            } else if (value == 7500) {
-                whitebalance = "3";
-            } else if (value == 2700) {
-                whitebalance = "4";
-            } else if (value == 4000) {
-                whitebalance = "5";
-            } else {
-                base::LogWarn() << "invalid white balance value " << value;
-                whitebalance = "0";
-            }
-        }
-        _camera_param.set_value(kWhitebalanceModeName, whitebalance);
-        return whitebalance;
-    } else {
-        set_whitebalance_mode(store_whitebalance);
-        return store_whitebalance;
-    }
-}
-
 bool CameraLocalClient::set_whitebalance_mode(std::string mode) {
     mav_camera::Result result;
     if (mode == "0") {  // Auto
@@ -843,18 +1071,6 @@ bool CameraLocalClient::set_whitebalance_mode(std::string mode) {
     return result == mav_camera::Result::Success;
 }
 
-std::string CameraLocalClient::init_exposure_mode() {
-    auto store_exposure_mode = _camera_param.get_value(kExposureMode);
-    if (store_exposure_mode.empty()) {
-        std::string exposure_mode = "0";  // default exposure mode is Auto
-        _camera_param.set_value(kExposureMode, exposure_mode);
-        return exposure_mode;
-    } else {
-        set_exposure_mode(store_exposure_mode);
-        return store_exposure_mode;
-    }
-}
-
 bool CameraLocalClient::set_exposure_mode(std::string mode) {
     mav_camera::Result result;
     if (mode == "0") {
@@ -865,203 +1081,61 @@ bool CameraLocalClient::set_exposure_mode(std::string mode) {
     return result == mav_camera::Result::Success;
 }
 
-std::string CameraLocalClient::init_exposure_value() {
-    auto store_ev = _camera_param.get_value(kEVName);
-    if (store_ev.empty()) {
-        std::string ev = "0.0";
-        auto [result, value] = _mav_camera->get_exposure_value();
-        if (result != mav_camera::Result::Success) {
-            base::LogError() << "Cannot get exposure value"
-                             << convert_camera_result_to_mav_server_result(result);
-            ev = "0.0";
-        } else {
-            std::ostringstream oss;
-            oss << std::fixed << std::setprecision(1) << value;
-            ev = oss.str();
-        }
-        _camera_param.set_value(kEVName, ev);
-        return ev;
-    } else {
-        // in auto exposure mode need set value again
-        if (_settings[kExposureMode] == "0") {
-            set_exposure_value(store_ev);
-        }
-        return store_ev;
-    }
-}
-
 bool CameraLocalClient::set_exposure_value(std::string exposure_value) {
     auto result = _mav_camera->set_exposure_value(std::stof(exposure_value));
     return result == mav_camera::Result::Success;
 }
 
-std::string CameraLocalClient::init_iso() {
-    auto store_iso = _camera_param.get_value(kISOName);
-    if (store_iso.empty()) {
-        auto [result, value] = _mav_camera->get_iso();
-        std::string iso;
-        if (result != mav_camera::Result::Success) {
-            base::LogError() << "Cannot get iso value"
-                             << convert_camera_result_to_mav_server_result(result);
-            iso = "100";
-        }
-        iso = std::to_string(value);
-        _camera_param.set_value(kISOName, iso);
-        return iso;
-    } else {
-        // in manual exposure mode need set value again
-        if (_settings[kExposureMode] == "1") {
-            set_iso(store_iso);
-        }
-        return store_iso;
-    }
-}
-
 bool CameraLocalClient::set_iso(std::string iso) {
     auto result = _mav_camera->set_iso(std::stoi(iso));
     return result == mav_camera::Result::Success;
 }
 
-std::string CameraLocalClient::init_shutter_speed() {
-    auto store_shutter_speed = _camera_param.get_value(kShutterSpeedName);
-    if (store_shutter_speed.empty()) {
-        std::string shutter_speed = "";
-        auto [result, value] = _mav_camera->get_shutter_speed();
-        if (result != mav_camera::Result::Success) {
-            base::LogDebug() << "Cannot get shutterspeed"
-                             << convert_camera_result_to_mav_server_result(result);
-            shutter_speed = "0.01";  // default value
-        }
-        std::size_t pos = value.find('/');
-        if (pos != std::string::npos) {
-            // Split the string at '/'
-            std::string num_str = value.substr(0, pos);
-            std::string den_str = value.substr(pos + 1);
-
-            // Convert to float
-            float numerator = std::stof(num_str);
-            float denominator = std::stof(den_str);
-
-            // Perform the division
-            auto convert_result = std::to_string(numerator / denominator);
-            base::LogDebug() << "current shutter speed is : " << convert_result;
-            shutter_speed = convert_result;
-        } else {
-            // If there is no '/', assume it's a whole number
-            shutter_speed = value;
-        }
-        _camera_param.set_value(kShutterSpeedName, shutter_speed);
-        return shutter_speed;
-    } else {
-        // in manual exposure mode need set value again
-        if (_settings[kExposureMode] == "1") {
-            set_shutter_speed(store_shutter_speed);
-        }
-        return store_shutter_speed;
-    }
-}
-
 bool CameraLocalClient::set_shutter_speed(std::string shutter_speed) {
     auto result = _mav_camera->set_shutter_speed(shutter_speed);
     return result == mav_camera::Result::Success;
 }
 
-std::string CameraLocalClient::init_video_format() {
-    auto store_video_format = _camera_param.get_value(kVideoFormat);
-    if (store_video_format.empty()) {
-        std::string video_format = "1";
-        _camera_param.set_value(kVideoFormat, video_format);
-        return video_format;
-    } else {
-        return store_video_format;
-    }
-}
-
-std::string CameraLocalClient::init_video_resolution() {
-    auto store_video_resolution = _camera_param.get_value(kVideoResolution);
-    if (store_video_resolution.empty()) {
-        std::string video_resolution = "";
-        auto [result, width, height] = _mav_camera->get_video_resolution();
-        if (result != mav_camera::Result::Success) {
-            base::LogError() << "Cannot get video resolution"
-                             << convert_camera_result_to_mav_server_result(result);
-            video_resolution = "0";
-        }
-        auto [result2, framerate] = _mav_camera->get_framerate();
-        if (result2 != mav_camera::Result::Success) {
-            base::LogError() << "Cannot get framerate"
-                             << convert_camera_result_to_mav_server_result(result);
-            video_resolution = "0";
-        }
-        base::LogDebug() << "Current video resolution is " << width << "x" << height << "@"
-                         << framerate;
-        if (width == 3840 && height == 2160 && framerate == 60) {
-            video_resolution = "0";
-        } else if (width == 3840 && height == 2160 && framerate == 30) {
-            video_resolution = "1";
-        } else if (width == 1920 && height == 1080 && framerate == 60) {
-            video_resolution = "2";
-        } else if (width == 1920 && height == 1080 && framerate == 30) {
-            video_resolution = "3";
-        } else {
-            base::LogError() << "Not found match resolution : " << width << "x" << height << "@"
-                             << framerate;
-            video_resolution = "0";
-        }
-        _camera_param.set_value(kVideoResolution, video_resolution);
-        return video_resolution;
-    } else {
-        set_video_resolution(store_video_resolution);
-        return store_video_resolution;
-    }
-}
-
 bool CameraLocalClient::set_video_resolution(std::string value) {
     int set_width = 0;
     int set_height = 0;
     int set_framerate = 0;
-    if (value == "0") {
-        set_width = 3840;
-        set_height = 2160;
-        set_framerate = 60;
-    } else if (value == "1") {
-        set_width = 3840;
-        set_height = 2160;
-        set_framerate = 30;
-    } else if (value == "2") {
-        set_width = 1920;
-        set_height = 1080;
-        set_framerate = 60;
-    } else if (value == "3") {
-        set_width = 1920;
-        set_height = 1080;
-        set_framerate = 30;
+    if (!video_format(value, set_width, set_height, set_framerate)) {
+        return false;
     }
+    // each call reconfigures the video stream, only change what differs from current format
+    int width = 0;
+    int height = 0;
+    int framerate = 0;
+    bool known = video_format(_settings[SettingId::CamVidres], width, height, framerate);
     base::LogDebug() << "Set video resolution to " << set_width << "x" << set_height << "@"
                      << set_framerate;
-    auto result = _mav_camera->set_video_resolution(set_width, set_height);
-    if (result != mav_camera::Result::Success) {
-        base::LogError() << "Failed to set video resolution : " << set_width << "x" << set_height;
+    auto result = mav_camera::Result::Success;
+    bool resolution_changed = !known || width != set_width || height != set_height;
+    if (resolution_changed) {
+        result = _mav_camera->set_video_resolution(set_width, set_height);
+        if (result != mav_camera::Result::Success) {
+            base::LogError() << "Failed to set video resolution : " << set_width << "x"
+                             << set_height;
+            return false;
+        }
     }
-    result = _mav_camera->set_framerate(set_framerate);
-    if (result != mav_camera::Result::Success) {
-        base::LogError() << "Failed to set video framerate : " << set_framerate;
+    if (!known || framerate != set_framerate) {
+        result = _mav_camera->set_framerate(set_framerate);
+        if (result != mav_camera::Result::Success) {
+            base::LogError() << "Failed to set video framerate : " << set_framerate;
+            // the setting keeps its old value, so the camera has to keep the old resolution too,
+            // an unknown old value differs from every request and is set again anyway
+            if (known && resolution_changed &&
+                _mav_camera->set_video_resolution(width, height) != mav_camera::Result::Success) {
+                base::LogError() << "Failed to restore video resolution : " << width << "x"
+                                 << height;
+            }
+        }
     }
     return result == mav_camera::Result::Success;
 }
 
-std::string CameraLocalClient::init_metering_mode() {
-    auto store_metering = _camera_param.get_value(kMeteringModeName);
-    if (store_metering.empty()) {
-        std::string metering = "0";
-        _camera_param.set_value(kMeteringModeName, metering);
-        return metering;
-    } else {
-        set_metering_mode(store_metering);
-        return store_metering;
-    }
-}
-
 bool CameraLocalClient::set_metering_mode(std::string value) {
     int32_t metering_mode = std::stoi(value);
     if (metering_mode < 0 || metering_mode > 4) {
@@ -1075,18 +1149,6 @@ bool CameraLocalClient::set_metering_mode(std::string value) {
     return result == mav_camera::Result::Success;
 }
 
-std::string CameraLocalClient::init_sharpness() {
-    auto store_sharpness = _camera_param.get_value(kSharpnessName);
-    if (store_sharpness.empty()) {
-        std::string sharpness = "0";
-        _camera_param.set_value(kSharpnessName, sharpness);
-        return sharpness;
-    } else {
-        set_sharpness(store_sharpness);
-        return store_sharpness;
-    }
-}
-
 bool CameraLocalClient::set_sharpness(std::string value) {
     int32_t sharpness = std::stoi(value);
     if (sharpness < 0 || sharpness > 2) {
@@ -1196,29 +1258,9 @@ void CameraLocalClient::free_ir_camera() {
     }
 }
 
-std::string CameraLocalClient::init_ir_palette() {
-    auto store_ir_palette = _camera_param.get_value(kIrCamPalette);
-    if (store_ir_palette.empty()) {
-        std::string palette;
-        if (_ir_camera != nullptr) {
-            uint32_t color_mode = 0;
-            _ir_camera->get(TYPE_CAMERA_COLOR_MODE, &color_mode);
-            base::LogDebug() << "Current ir palette is " << int(color_mode);
-            palette = std::to_string(color_mode);
-        } else {  // When ir camera init failed, just add empty value for settings
-            palette = "0";
-        }
-        _camera_param.set_value(kIrCamPalette, palette);
-        return palette;
-    } else {
-        set_ir_palette(store_ir_palette);
-        return store_ir_palette;
-    }
-}
-
 bool CameraLocalClient::set_ir_palette(std::string color_mode) {
     uint32_t convert_mode = std::stoul(color_mode);
-    if (_ir_camera != nullptr) {
+    if (_ir_ready.load(std::memory_order_acquire)) {
         auto result = _ir_camera->set(TYPE_CAMERA_COLOR_MODE, &convert_mode);
         if (result != 0) {
             base::LogError() << "Set ir palette failed";
@@ -1229,7 +1271,7 @@ bool CameraLocalClient::set_ir_palette(std::string color_mode) {
 }
 
 bool CameraLocalClient::set_ir_FFC(std::string /*ignore*/) {
-    if (_ir_camera != nullptr) {
+    if (_ir_ready.load(std::memory_order_acquire)) {
         auto result = _ir_camera->exec(TYPE_CAMERA_FFC);
         return result == 0;
     }
@@ -1257,13 +1299,37 @@ void CameraLocalClient::check_sdcard_status() {
     }
 }
 
-mavsdk::Camera::Setting CameraLocalClient::build_setting(std::string name, std::string value) {
+bool CameraLocalClient::is_valid_value(SettingId id, const std::string &value) {
+    const auto &info = settings::setting_info(id);
+    if (info.type == settings::SettingType::Int32) {
+        return settings::find_option(id, value) != nullptr;
+    }
+    // float params come from the param server and do not match the option text
+    char *end = nullptr;
+    double number = strtod(value.c_str(), &end);
+    return !value.empty() && *end == '\0' && number >= info.min && number <= info.max;
+}
+
+void CameraLocalClient::update_setting(SettingId id, const std::string &value) {
+    std::lock_guard<std::mutex> lock(_settings_mutex);
+    _settings[id] = value;
+}
+
+mavsdk::Camera::Setting CameraLocalClient::build_setting(SettingId id, std::string value) {
     mavsdk::Camera::Setting setting;
-    setting.setting_id = name;
+    setting.setting_id = settings::setting_name(id);
     setting.option.option_id = value;
     return setting;
 }
 
+std::string CameraLocalClient::load_param(SettingId id) {
+    return _camera_param.get_value(settings::setting_name(id));
+}
+
+void CameraLocalClient::store_param(SettingId id, const std::string &value) {
+    _camera_param.set_value(settings::setting_name(id), value);
+}
+
 mavsdk::CameraServer::Result CameraLocalClient::convert_camera_result_to_mav_server_result(
     mav_camera::Result input_result) {
     mavsdk::CameraServer::Result output_result = mavsdk::CameraServer::Result::Unknown;
@@ -3,11 +3,12 @@
 #include <atomic>
 #include <chrono>
 #include <mutex>
-#include <unordered_map>
+#include <thread>
 #include <vector>
 
 #include "camera_client.h"
 #include "camera_param/camera_param.h"
+#include "camera_settings.h"
 #include "libirextension.h"
 #include "mav_camera.h"
 #include "plugins/camera/camera.h"
@@ -44,6 +45,8 @@ public:  // settings
     virtual mavsdk::CameraServer::Result retrieve_current_settings(
         std::vector<mavsdk::Camera::Setting> &settings) override;
     mavsdk::CameraServer::Result set_setting(mavsdk::Camera::Setting setting) override;
+    mavsdk::CameraServer::Result set_settings(
+        std::vector<mavsdk::Camera::Setting> settings) override;
     std::pair<mavsdk::CameraServer::Result, mavsdk::Camera::Setting> get_setting(
         mavsdk::Camera::Setting setting) const override;
 public:
@@ -57,93 +60,75 @@ private:
      */
     void deinit();
     /**
-     * @brief get current camera display mode
+     * @brief writes to camera done and skipped during init
      */
-    std::string init_camera_display_mode();
+    struct InitStats {
+        int applied{0};
+        int skipped{0};
+    };
+    /**
+     * @brief init one setting from its stored value
+     * @details the stored value is only written when apply is set and it differs from the
+     * hardware value, without stored value the hardware value or the default is stored
+     * @param hardware value camera runs with, empty when unknown
+     * @return value of the setting
+     */
+    std::string init_setting(settings::SettingId id, const std::string &hardware, bool apply,
+                             InitStats &stats);
+    /**
+     * @brief read the settings camera can report, the others stay empty
+     */
+    void read_hardware_settings(settings::SettingValues &values);
+    /**
+     * @brief current ir camera palette, empty when unknown
+     */
+    std::string read_ir_palette();
+    static bool is_same_value(settings::SettingId id, const std::string &lhs,
+                              const std::string &rhs);
+    /**
+     * @brief validate and apply settings, caller holds _mutex
+     * @details settings already at the requested value are skipped, when one fails the ones
+     * applied before are restored and nothing is stored
+     */
+    mavsdk::CameraServer::Result apply_settings(
+        const std::vector<mavsdk::Camera::Setting> &settings);
+    /**
+     * @brief change one setting on camera, _settings is not updated
+     */
+    bool apply_setting(settings::SettingId id, const std::string &value);
     /**
      * @brief set camera display mode
      */
     bool set_camera_display_mode(std::string mode);
-    /**
-     * @brief get camera whitebalance mode
-    */
-    std::string init_whitebalance_mode();
     /**
      * @brief set whitebalance mode
     */
     bool set_whitebalance_mode(std::string mode);
-    /**
-     * @brief init exposure mode
-     * @details prefer to use store exposure mode
-     * @return current exposure mode, 0 for Auto, 1 for Manual
-     */
-    std::string init_exposure_mode();
     /**
      * @brief set exposure mode
      */
     bool set_exposure_mode(std::string mode);
-    /**
-     * @brief init camera exposure value
-     * @details prefer to use store exposure value
-     * @return current exposure value
-     */
-    std::string init_exposure_value();
     /**
      * @brief set exposure value
      */
     bool set_exposure_value(std::string exposure_value);
-    /**
-     * @brief init camera iso value
-     * @details prefer to use store iso value
-     * @return current iso value
-     */
-    std::string init_iso();
     /**
      * @brief set iso value
     */
     bool set_iso(std::string iso);
-    /**
-     * @brief init shutter speed
-     * @details prefer to use store shutter speed
-     * @return current shutter speed
-     */
-    std::string init_shutter_speed();
     /**
      * @brief set shutter speed
     */
     bool set_shutter_speed(std::string shutter_speed);
-    /**
-     * @brief init video format
-     * @details prefer to use store video format
-     * @return current video format
-     */
-    std::string init_video_format();
-    /**
-     * @brief init video resoltuion
-     * @details prefer to use store video resolution
-     * @return current video resolution
-     */
-    std::string init_video_resolution();
     /**
      * @brief set video resoltuion
+     * @details resolution and framerate are only changed when they differ from current one
      */
     bool set_video_resolution(std::string value);
-    /**
-     * @brief init camera metering mode
-     * @details prefer to use store metering mode
-     * @return current metering mode
-     */
-    std::string init_metering_mode();
     /**
      * @brief set metering mode
      */
     bool set_metering_mode(std::string value);
-    /**
-     * @brief init sharpness value
-     * @details prefer to use store sharpness value
-     * @return current sharpness value
-     */
-    std::string init_sharpness();
     /**
      * @brief set sharpness value
      */
@@ -157,15 +142,13 @@ private:
      */
     bool init_ir_camera();
     /**
-     * @breif free ir camera
+     * @brief init ir camera and apply its stored settings, runs beside rgb camera init
      */
-    void free_ir_camera();
+    static void ir_init_thread(CameraLocalClient *self);
     /**
-     * @brief init ir camera palette
-     * @details prefer to use store ir palette
-     * @return current ir palette
+     * @breif free ir camera
      */
-    std::string init_ir_palette();
+    void free_ir_camera();
     /**
      * @brief set ir camera palette
      */
@@ -179,7 +162,14 @@ private:
      */
     void check_sdcard_status();
 private:
-    mavsdk::Camera::Setting build_setting(std::string name, std::string value);
+    static bool is_valid_value(settings::SettingId id, const std::string &value);
+    void update_setting(settings::SettingId id, const std::string &value);
+    mavsdk::Camera::Setting build_setting(settings::SettingId id, std::string value);
+    /**
+     * @brief stored value of a setting, empty when never stored
+     */
+    std::string load_param(settings::SettingId id);
+    void store_param(settings::SettingId id, const std::string &value);
     mavsdk::CameraServer::Result convert_camera_result_to_mav_server_result(
         mav_camera::Result input_result);
 private:
@@ -189,7 +179,10 @@ private:
     mutable mavsdk::CameraServer::Mode _current_mode{mavsdk::CameraServer::Mode::Unknown};
     mutable std::mutex _storage_information_mutex;
     mutable mav_camera::StorageInformation _current_storage_information;
-    mutable std::unordered_map<std::string, std::string> _settings;
+    // only written by update_setting() of a thread holding _mutex or still in init(), so readers
+    // holding _mutex need no _settings_mutex, the others do
+    settings::SettingValues _settings;
+    mutable std::mutex _settings_mutex{};
     int32_t _framerate;
 private:
     std::mutex _mutex{};
@@ -199,6 +192,8 @@ private:
 private:
     void *_ir_camera_handle{NULL};
     struct ir_extension_api *_ir_camera{nullptr};
+    std::atomic<bool> _ir_ready{false};  ///< _ir_camera is initialized, set by init thread
+    std::thread *_ir_init_thread{nullptr};
 private:
     CameraParam _camera_param;
     bool _sdcard_valid{true};
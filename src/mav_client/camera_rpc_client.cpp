@@ -3,12 +3,16 @@
 #include <chrono>
 #include <string>
 
+#include "base/heartbeat.h"
 #include "base/log.h"
+#include "base/startup_profiler.h"
 #include "camera/camera.pb.h"
+#include "camera_settings.h"
 
 namespace mavcam {
 
-static std::string kCameraModeName = "CAM_MODE";
+static const std::string kCameraModeName =
+    settings::setting_name(settings::SettingId::CamMode);
 
 static mavsdk::CameraServer::Result translateFromRpcResult(
     const mavcam::rpc::camera::CameraResult_Result result);
@@ -49,14 +53,18 @@ CameraRpcClient::~CameraRpcClient() {
 bool CameraRpcClient::init(int rpc_port) {
     std::string target = "0.0.0.0:" + std::to_string(rpc_port);
     // the channel isn't authenticated
+    base::StartupPhase channel_phase("grpc_channel");
     _channel = grpc::CreateChannel(target, grpc::InsecureChannelCredentials());
     _stub = mavcam::rpc::camera::CameraService::NewStub(_channel);
+    channel_phase.stop();
 
     // call prepare to init mav camera
     mavcam::rpc::camera::PrepareRequest request;
     grpc::ClientContext context;
     mavcam::rpc::camera::PrepareResponse response;
+    base::StartupPhase prepare_phase("grpc_prepare");
     grpc::Status status = _stub->Prepare(&context, request, &response);
+    prepare_phase.stop();
     if (!status.ok()) {
         base::LogError() << "Call rpc prepare failed with errorcode: " << status.error_code();
         return false;
@@ -352,6 +360,42 @@ mavsdk::CameraServer::Result CameraRpcClient::retrieve_current_settings(
 
 mavsdk::CameraServer::Result CameraRpcClient::set_setting(mavsdk::Camera::Setting setting) {
     std::lock_guard<std::mutex> lock(_mutex);
+    return send_setting(setting);
+}
+
+mavsdk::CameraServer::Result CameraRpcClient::set_settings(
+    std::vector<mavsdk::Camera::Setting> settings) {
+    // camera service has no batch request, send them back to back without other calls between
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::vector<mavsdk::Camera::Setting> previous;
+    previous.reserve(settings.size());
+    for (const auto &setting : settings) {
+        auto [result, current] = fetch_setting(setting);
+        if (result != mavsdk::CameraServer::Result::Success) {
+            base::LogError() << "Cannot read " << setting.setting_id << " before setting it";
+            return result;
+        }
+        previous.push_back(current);
+    }
+    for (size_t i = 0; i < settings.size(); i++) {
+        auto result = send_setting(settings[i]);
+        if (result == mavsdk::CameraServer::Result::Success) {
+            continue;
+        }
+        // restore in reverse order, a later setting may depend on an earlier one
+        while (i-- > 0) {
+            if (send_setting(previous[i]) != mavsdk::CameraServer::Result::Success) {
+                base::LogError() << "Cannot restore " << previous[i].setting_id << " to "
+                                 << previous[i].option.option_id;
+            }
+        }
+        return result;
+    }
+    return mavsdk::CameraServer::Result::Success;
+}
+
+mavsdk::CameraServer::Result CameraRpcClient::send_setting(
+    const mavsdk::Camera::Setting &setting) {
     base::LogDebug() << "rpc call set " << setting.setting_id << " to " << setting.option.option_id;
 
     mavcam::rpc::camera::SetSettingRequest request;
@@ -377,16 +421,20 @@ mavsdk::CameraServer::Result CameraRpcClient::set_setting(mavsdk::Camera::Settin
 
     base::LogDebug() << "Set settings result : " << response.camera_result().result_str();
     return translateFromRpcResult(response.camera_result().result());
-
-    return mavsdk::CameraServer::Result::Success;
 }
 
 std::pair<mavsdk::CameraServer::Result, mavsdk::Camera::Setting> CameraRpcClient::get_setting(
     mavsdk::Camera::Setting setting) const {
     std::lock_guard<std::mutex> lock(_mutex);
+    return fetch_setting(setting);
+}
+
+std::pair<mavsdk::CameraServer::Result, mavsdk::Camera::Setting> CameraRpcClient::fetch_setting(
+    mavsdk::Camera::Setting setting) const {
     base::LogDebug() << "rpc call get setting " << setting.setting_id;
 
     mavcam::rpc::camera::GetSettingRequest request;
+    request.set_allocated_setting(createRPCSetting(setting.setting_id, "", "", "").release());
     grpc::ClientContext context;
 
     mavcam::rpc::camera::GetSettingResponse response;
@@ -403,7 +451,7 @@ std::pair<mavsdk::CameraServer::Result, mavsdk::Camera::Setting> CameraRpcClient
     setting.option.option_description = response.setting().option().option_description();
     setting.is_range = response.setting().is_range();
 
-    return {mavsdk::CameraServer::Result::Success, setting};
+    return {translateFromRpcResult(response.camera_result().result()), setting};
 }
 
 void CameraRpcClient::stop() {
@@ -417,18 +465,21 @@ void CameraRpcClient::stop() {
 
 void CameraRpcClient::work_thread(CameraRpcClient *self) {
     while (!self->_should_exit) {
-        mavcam::rpc::camera::SubscribeStatusRequest request;
-        grpc::ClientContext context;
-        auto status_reader = self->_stub->SubscribeStatus(&context, request);
-
-        mavcam::rpc::camera::StatusResponse response;
-        if (status_reader->Read(&response)) {
-            fillStorageInformation(response.camera_status(), self->_storage_information);
-            fillCaptureStatus(response.camera_status(), self->_capture_status);
-            // TODO need change
-            self->_capture_status.image_count = self->_image_count;
+        {
+            base::HeartbeatScope heartbeat("rpc_status");
+            mavcam::rpc::camera::SubscribeStatusRequest request;
+            grpc::ClientContext context;
+            auto status_reader = self->_stub->SubscribeStatus(&context, request);
+
+            mavcam::rpc::camera::StatusResponse response;
+            if (status_reader->Read(&response)) {
+                fillStorageInformation(response.camera_status(), self->_storage_information);
+                fillCaptureStatus(response.camera_status(), self->_capture_status);
+                // TODO need change
+                self->_capture_status.image_count = self->_image_count;
+            }
+            status_reader->Finish();
         }
-        status_reader->Finish();
         std::this_thread::sleep_for(std::chrono::milliseconds(1000));
     }
 }
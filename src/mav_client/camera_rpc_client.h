@@ -44,6 +44,8 @@ public:  // settings
     virtual mavsdk::CameraServer::Result retrieve_current_settings(
         std::vector<mavsdk::Camera::Setting> &settings) override;
     virtual mavsdk::CameraServer::Result set_setting(mavsdk::Camera::Setting setting) override;
+    virtual mavsdk::CameraServer::Result set_settings(
+        std::vector<mavsdk::Camera::Setting> settings) override;
     virtual std::pair<mavsdk::CameraServer::Result, mavsdk::Camera::Setting> get_setting(
         mavsdk::Camera::Setting setting) const override;
 public:
@@ -51,6 +53,15 @@ public:
 private:
     void stop();
     static void work_thread(CameraRpcClient *self);
+    /**
+     * @brief send one SetSetting request, caller holds _mutex
+     */
+    mavsdk::CameraServer::Result send_setting(const mavsdk::Camera::Setting &setting);
+    /**
+     * @brief send one GetSetting request, caller holds _mutex
+     */
+    std::pair<mavsdk::CameraServer::Result, mavsdk::Camera::Setting> fetch_setting(
+        mavsdk::Camera::Setting setting) const;
 private:
     std::atomic<bool> _is_capture_in_progress;
     std::atomic<int> _image_count;
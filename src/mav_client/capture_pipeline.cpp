@@ -0,0 +1,152 @@
+#include "capture_pipeline.h"
+
+#include <algorithm>
+
+#include "base/heartbeat.h"
+#include "base/log.h"
+
+namespace mavcam {
+
+// photos older than this do not count for the rate any more
+static constexpr auto kRateWindow = std::chrono::seconds(2);
+
+CapturePipeline::CapturePipeline(size_t max_in_flight) : _max_in_flight(max_in_flight) {}
+
+CapturePipeline::~CapturePipeline() {
+    stop();
+}
+
+void CapturePipeline::set_max_in_flight(size_t max_in_flight) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _max_in_flight = std::max<size_t>(max_in_flight, 1);
+}
+
+void CapturePipeline::start(Trigger trigger, Report report) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_trigger_thread != nullptr) {
+        return;
+    }
+    _trigger = std::move(trigger);
+    _report = std::move(report);
+    _should_exit = false;
+    _trigger_thread = new std::thread(trigger_thread, this);
+    _report_thread = new std::thread(report_thread, this);
+}
+
+void CapturePipeline::stop() {
+    std::thread *threads[2] = {};
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _should_exit = true;
+        threads[0] = _trigger_thread;
+        threads[1] = _report_thread;
+        _trigger_thread = nullptr;
+        _report_thread = nullptr;
+    }
+    _trigger_cv.notify_one();
+    _report_cv.notify_one();
+    for (auto *thread : threads) {
+        if (thread != nullptr) {
+            thread->join();
+            delete thread;
+        }
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    _requests.clear();
+    _taken.clear();
+    _in_flight = 0;
+}
+
+bool CapturePipeline::submit(uint32_t shots, const Origin &origin) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_trigger_thread == nullptr || shots == 0) {
+            return false;
+        }
+        if (_requests.size() >= _max_in_flight) {
+            base::LogWarn() << "Refuse capture of " << shots << " photos, " << _requests.size()
+                            << " requests are waiting";
+            return false;
+        }
+        _requests.push_back(Request{shots, 0, origin});
+    }
+    _trigger_cv.notify_one();
+    return true;
+}
+
+bool CapturePipeline::busy() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return !_requests.empty() || _in_flight > 0;
+}
+
+float CapturePipeline::frames_per_second() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    size_t samples = std::min(_shot_count, kRateSamples);
+    if (samples < 2) {
+        return 0.0f;
+    }
+    auto newest = _shot_times[(_shot_count - 1) % kRateSamples];
+    auto oldest = _shot_times[(_shot_count - samples) % kRateSamples];
+    if (std::chrono::steady_clock::now() - newest > kRateWindow || newest <= oldest) {
+        return 0.0f;
+    }
+    return (samples - 1) / std::chrono::duration<float>(newest - oldest).count();
+}
+
+void CapturePipeline::trigger_thread(CapturePipeline *self) {
+    std::unique_lock<std::mutex> lock(self->_mutex);
+    while (!self->_should_exit) {
+        if (self->_requests.empty() || self->_in_flight >= self->_max_in_flight) {
+            self->_trigger_cv.wait(lock);
+            continue;
+        }
+        Request &request = self->_requests.front();
+        int32_t index = self->_next_index++;
+        uint32_t shot = request.taken++;
+        Origin origin = request.origin;
+        if (request.taken == request.shots) {
+            self->_requests.pop_front();
+        }
+        self->_in_flight++;
+        lock.unlock();
+        bool success = false;
+        {
+            base::HeartbeatScope heartbeat("capture_trigger");
+            success = self->_trigger(index);
+        }
+        auto time_utc_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                               std::chrono::system_clock::now().time_since_epoch())
+                               .count();
+        auto taken = std::chrono::steady_clock::now();
+        lock.lock();
+        self->_shot_times[self->_shot_count % kRateSamples] = taken;
+        self->_shot_count++;
+        self->_taken.push_back(Capture{index, shot, success, static_cast<uint64_t>(time_utc_us),
+                                       taken, origin, false});
+        self->_report_cv.notify_one();
+    }
+}
+
+void CapturePipeline::report_thread(CapturePipeline *self) {
+    std::unique_lock<std::mutex> lock(self->_mutex);
+    while (!self->_should_exit) {
+        if (self->_taken.empty()) {
+            self->_report_cv.wait(lock);
+            continue;
+        }
+        Capture capture = self->_taken.front();
+        self->_taken.pop_front();
+        // released before the report, so the report of the last photo sees the pipeline idle
+        self->_in_flight--;
+        capture.last = self->_taken.empty() && self->_requests.empty() && self->_in_flight == 0;
+        self->_trigger_cv.notify_one();
+        lock.unlock();
+        {
+            base::HeartbeatScope heartbeat("capture_report");
+            self->_report(capture);
+        }
+        lock.lock();
+    }
+}
+
+}  // namespace mavcam
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace mavcam {
+
+/**
+ * @brief Photo capture split into a trigger stage and a report stage
+ * @details The trigger thread takes photos back to back while the report thread sends the
+ * capture info of finished ones, so the next photo does not wait for the MAVLink round trip of
+ * the previous one. At most max_in_flight photos wait for their report, the trigger
+ * stage waits when reporting falls behind. A request of several shots is a burst, its shots are
+ * taken at the highest rate the camera allows.
+ */
+class CapturePipeline final {
+public:
+    /**
+     * @brief what asked for a photo, carried through to its report
+     */
+    struct Origin {
+        std::chrono::steady_clock::time_point requested{};
+        bool command{false};  ///< a take photo command, answered by the first photo only
+        int32_t sequence{0};  ///< capture sequence the command carries
+        uint16_t sender{0};   ///< of a single photo command, 0 for an interval tick
+        bool survey{false};  ///< fired by the survey trigger, position is where it fired
+        double latitude_deg{0.0};
+        double longitude_deg{0.0};
+        float absolute_altitude_m{0.0f};
+        float relative_altitude_m{0.0f};
+    };
+    struct Capture {
+        int32_t index{0};   ///< image index, counts every photo taken
+        uint32_t shot{0};   ///< 0 for the first photo of its request
+        bool success{false};
+        uint64_t time_utc_us{0};
+        std::chrono::steady_clock::time_point taken{};  ///< camera returned from the photo
+        Origin origin{};
+        bool last{false};  ///< nothing else is queued or in flight
+    };
+    using Trigger = std::function<bool(int32_t index)>;
+    using Report = std::function<void(const Capture &capture)>;
+public:
+    explicit CapturePipeline(size_t max_in_flight);
+    ~CapturePipeline();
+public:
+    /**
+     * @brief photos taken but not reported yet, and requests waiting, call before start()
+     */
+    void set_max_in_flight(size_t max_in_flight);
+    /**
+     * @param trigger takes one photo, runs on trigger thread
+     * @param report sends capture info of one photo, runs on report thread
+     */
+    void start(Trigger trigger, Report report);
+    /**
+     * @brief stop both threads, shots not taken yet are dropped
+     */
+    void stop();
+    /**
+     * @brief queue shots photos
+     * @return false when not running or max_in_flight requests are waiting already
+     */
+    bool submit(uint32_t shots, const Origin &origin);
+    /**
+     * @brief a request is waiting or a photo is not handed to report yet
+     */
+    bool busy() const;
+    /**
+     * @brief rate of the recent photos, 0 when none was taken lately
+     */
+    float frames_per_second() const;
+private:
+    struct Request {
+        uint32_t shots{0};
+        uint32_t taken{0};
+        Origin origin{};
+    };
+    static constexpr size_t kRateSamples = 8;
+private:
+    static void trigger_thread(CapturePipeline *self);
+    static void report_thread(CapturePipeline *self);
+private:
+    size_t _max_in_flight;
+    Trigger _trigger{};
+    Report _report{};
+    mutable std::mutex _mutex{};
+    std::condition_variable _trigger_cv{};
+    std::condition_variable _report_cv{};
+    std::deque<Request> _requests{};
+    std::deque<Capture> _taken{};  ///< waiting for report
+    size_t _in_flight{0};          ///< taken or being taken, not handed to report yet
+    int32_t _next_index{0};        ///< image index of the next photo, kept over stop()
+    std::chrono::steady_clock::time_point _shot_times[kRateSamples]{};
+    size_t _shot_count{0};
+    std::thread *_trigger_thread{nullptr};
+    std::thread *_report_thread{nullptr};
+    bool _should_exit{false};
+};
+
+}  // namespace mavcam
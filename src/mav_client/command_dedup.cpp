@@ -0,0 +1,64 @@
+#include "command_dedup.h"
+
+namespace mavcam {
+
+CommandDedup::CommandDedup(std::chrono::steady_clock::duration window, size_t capacity)
+    : _window(window), _entries(capacity) {}
+
+CommandDedup::State CommandDedup::begin(uint16_t sender, uint16_t command, int32_t key,
+                                        Replay &replay) {
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(_mutex);
+    Entry *slot = find_locked(sender, command, key);
+    if (slot != nullptr && !expired(*slot, now)) {
+        if (!slot->done) {
+            return State::Running;
+        }
+        replay = slot->replay;
+        return State::Done;
+    }
+    // reuse the expired entry of this command, else an unused or expired one, else the oldest
+    if (slot == nullptr) {
+        for (auto &candidate : _entries) {
+            if (expired(candidate, now)) {
+                slot = &candidate;
+                break;
+            }
+            if (slot == nullptr || candidate.time < slot->time) {
+                slot = &candidate;
+            }
+        }
+    }
+    if (slot != nullptr) {
+        *slot = Entry{sender, command, key, now, true, false, nullptr};
+    }
+    return State::New;
+}
+
+void CommandDedup::finish(uint16_t sender, uint16_t command, int32_t key, Replay replay) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    Entry *entry = find_locked(sender, command, key);
+    if (entry != nullptr && !entry->done) {
+        entry->done = true;
+        entry->replay = std::move(replay);
+    }
+}
+
+void CommandDedup::forget(uint16_t sender, uint16_t command, int32_t key) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    Entry *entry = find_locked(sender, command, key);
+    if (entry != nullptr) {
+        *entry = Entry{};
+    }
+}
+
+CommandDedup::Entry *CommandDedup::find_locked(uint16_t sender, uint16_t command, int32_t key) {
+    for (auto &entry : _entries) {
+        if (entry.used && entry.sender == sender && entry.command == command && entry.key == key) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+}  // namespace mavcam
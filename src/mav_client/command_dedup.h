@@ -0,0 +1,68 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace mavcam {
+
+/**
+ * @brief Recognizes commands the ground station sent again before it got our answer
+ * @details A command is keyed on its sender, its MAV_CMD number and the sequence it carries. A
+ * repeat within the window is not run again, while the first one is still running it is dropped,
+ * once that finished the cached answer is sent again. The window starts when the first one
+ * begins and should cover the retransmit timeout of the ground station. Entries older than the
+ * window are reused first, so the table stays at capacity entries.
+ */
+class CommandDedup final {
+public:
+    enum class State : uint8_t {
+        New,      ///< not seen in the window, recorded as running now
+        Running,  ///< the first one has not finished yet
+        Done,     ///< replay holds the answer of the first one
+    };
+    using Replay = std::function<void()>;
+public:
+    CommandDedup(std::chrono::steady_clock::duration window, size_t capacity);
+public:
+    /**
+     * @param sender system and component id of the ground station, system id in the high byte
+     * @param replay set to the cached answer when Done
+     */
+    State begin(uint16_t sender, uint16_t command, int32_t key, Replay &replay);
+    /**
+     * @brief store the answer of a command, ignored when it was not begun
+     */
+    void finish(uint16_t sender, uint16_t command, int32_t key, Replay replay);
+    /**
+     * @brief drop a command that was refused, so a repeat runs it
+     */
+    void forget(uint16_t sender, uint16_t command, int32_t key);
+private:
+    struct Entry {
+        uint16_t sender{0};
+        uint16_t command{0};
+        int32_t key{0};
+        std::chrono::steady_clock::time_point time{};
+        bool used{false};
+        bool done{false};
+        Replay replay{};
+    };
+private:
+    /**
+     * @brief entry of a command, also when it is expired
+     */
+    Entry *find_locked(uint16_t sender, uint16_t command, int32_t key);
+    bool expired(const Entry &entry, std::chrono::steady_clock::time_point now) const {
+        return !entry.used || now - entry.time > _window;
+    }
+private:
+    const std::chrono::steady_clock::duration _window;
+    std::mutex _mutex{};
+    std::vector<Entry> _entries{};
+};
+
+}  // namespace mavcam
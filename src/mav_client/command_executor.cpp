@@ -0,0 +1,106 @@
+#include "command_executor.h"
+
+#include "base/heartbeat.h"
+#include "base/log.h"
+
+namespace mavcam {
+
+// also the heartbeat names of the lane threads
+static const char *kLaneNames[] = {"capture_lane", "settings_lane", "query_lane"};
+
+CommandExecutor::CommandExecutor(size_t max_pending) : _max_pending(max_pending) {}
+
+CommandExecutor::~CommandExecutor() {
+    stop();
+}
+
+void CommandExecutor::start() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_running) {
+        return;
+    }
+    _running = true;
+    for (size_t i = 0; i < kLaneCount; i++) {
+        _lanes[i].work_thread = new std::thread(work_thread, this, static_cast<Lane>(i));
+    }
+}
+
+void CommandExecutor::stop() {
+    std::thread *threads[kLaneCount] = {};
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _running = false;
+        for (size_t i = 0; i < kLaneCount; i++) {
+            threads[i] = _lanes[i].work_thread;
+            _lanes[i].work_thread = nullptr;
+            _lanes[i].pending.clear();
+            _lanes[i].finished = _lanes[i].posted;
+        }
+    }
+    for (size_t i = 0; i < kLaneCount; i++) {
+        _lanes[i].cv.notify_one();
+        _lanes[i].done_cv.notify_all();
+        if (threads[i] != nullptr) {
+            threads[i]->join();
+            delete threads[i];
+        }
+    }
+}
+
+bool CommandExecutor::post(Lane lane, Command command) {
+    LaneState &state = _lanes[static_cast<size_t>(lane)];
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_running) {
+            base::LogWarn() << "Drop " << kLaneNames[static_cast<size_t>(lane)]
+                            << " command, executor is not running";
+            return false;
+        }
+        if (state.pending.size() >= _max_pending) {
+            base::LogWarn() << "Refuse " << kLaneNames[static_cast<size_t>(lane)] << " command, "
+                            << state.pending.size() << " commands are waiting";
+            return false;
+        }
+        state.pending.push_back(std::move(command));
+        state.posted++;
+    }
+    state.cv.notify_one();
+    return true;
+}
+
+uint64_t CommandExecutor::ticket(Lane lane) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _lanes[static_cast<size_t>(lane)].posted;
+}
+
+void CommandExecutor::wait_done(Lane lane, uint64_t ticket) {
+    LaneState &state = _lanes[static_cast<size_t>(lane)];
+    std::unique_lock<std::mutex> lock(_mutex);
+    state.done_cv.wait(lock, [this, &state, ticket]() {
+        return !_running || state.finished >= ticket;
+    });
+}
+
+void CommandExecutor::work_thread(CommandExecutor *self, Lane lane) {
+    const char *name = kLaneNames[static_cast<size_t>(lane)];
+    LaneState &state = self->_lanes[static_cast<size_t>(lane)];
+    std::unique_lock<std::mutex> lock(self->_mutex);
+    while (self->_running) {
+        if (state.pending.empty()) {
+            state.cv.wait(lock);
+            continue;
+        }
+        Command command = std::move(state.pending.front());
+        state.pending.pop_front();
+        lock.unlock();
+        {
+            base::HeartbeatScope heartbeat(name);
+            command();
+        }
+        lock.lock();
+        state.finished++;
+        state.done_cv.notify_all();
+    }
+}
+
+}  // namespace mavcam
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace mavcam {
+
+/**
+ * @brief Runs camera commands away from the MAVSDK callback thread
+ * @details Every lane owns a worker thread and a bounded queue, commands of one lane run in order
+ * of arrival. Lanes never wait for each other, so a query is not queued behind a capture and a
+ * slow capture does not hold back a settings change. Commands respond to the ground station
+ * themselves once they are done.
+ */
+class CommandExecutor final {
+public:
+    enum class Lane : uint8_t {
+        Capture,   ///< photo, video, streaming and storage operations, may take seconds
+        Settings,  ///< mode and setting changes
+        Query,     ///< read only requests
+    };
+    using Command = std::function<void()>;
+public:
+    /**
+     * @param max_pending commands a lane holds before further ones are refused
+     */
+    explicit CommandExecutor(size_t max_pending);
+    ~CommandExecutor();
+public:
+    void start();
+    /**
+     * @brief stop worker threads, commands still waiting are dropped
+     */
+    void stop();
+    /**
+     * @brief queue a command on a lane
+     * @return false when executor is not running or lane is full, the caller answers busy then
+     */
+    bool post(Lane lane, Command command);
+    /**
+     * @brief count of commands posted to a lane so far, wait_done() on it to run after them
+     */
+    uint64_t ticket(Lane lane);
+    /**
+     * @brief block until the commands posted to a lane before ticket() returned are done
+     * @details also returns when the executor stops, never call it from the lane itself
+     */
+    void wait_done(Lane lane, uint64_t ticket);
+private:
+    static constexpr size_t kLaneCount = 3;
+    struct LaneState {
+        std::deque<Command> pending{};
+        std::condition_variable cv{};
+        std::thread *work_thread{nullptr};
+        uint64_t posted{0};
+        uint64_t finished{0};  ///< commands run or dropped
+        std::condition_variable done_cv{};
+    };
+private:
+    static void work_thread(CommandExecutor *self, Lane lane);
+private:
+    const size_t _max_pending;
+    std::mutex _mutex{};
+    LaneState _lanes[kLaneCount]{};
+    bool _running{false};
+};
+
+}  // namespace mavcam
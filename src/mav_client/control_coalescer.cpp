@@ -0,0 +1,126 @@
+#include "control_coalescer.h"
+
+#include <algorithm>
+
+#include "base/heartbeat.h"
+#include "base/log.h"
+
+namespace mavcam {
+
+ControlCoalescer::ControlCoalescer(std::chrono::milliseconds min_interval)
+    : _min_interval(min_interval) {}
+
+ControlCoalescer::~ControlCoalescer() {
+    stop();
+}
+
+void ControlCoalescer::start() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_work_thread != nullptr) {
+        return;
+    }
+    _should_exit = false;
+    _work_thread = new std::thread(work_thread, this);
+}
+
+void ControlCoalescer::stop() {
+    std::thread *thread = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _should_exit = true;
+        thread = _work_thread;
+        _work_thread = nullptr;
+        _slots.clear();
+    }
+    _cv.notify_one();
+    if (thread != nullptr) {
+        thread->join();
+        delete thread;
+    }
+}
+
+void ControlCoalescer::submit(const std::string &control, Apply apply) {
+    submit(
+        control,
+        [apply = std::move(apply)]() {
+            apply();
+            return true;
+        },
+        nullptr);
+}
+
+void ControlCoalescer::submit(const std::string &control, std::function<bool()> apply,
+                              Answer superseded) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_work_thread == nullptr) {
+            base::LogWarn() << "Drop " << control << " request, coalescer is not running";
+            return;
+        }
+        Slot &slot = _slots[control];
+        if (slot.pending) {
+            slot.dropped++;
+            if (slot.answer) {
+                slot.superseded.push_back(std::move(slot.answer));
+            }
+        } else {
+            slot.sequence = ++_sequence;
+        }
+        slot.pending = std::move(apply);
+        slot.answer = std::move(superseded);
+    }
+    _cv.notify_one();
+}
+
+void ControlCoalescer::work_thread(ControlCoalescer *self) {
+    std::unique_lock<std::mutex> lock(self->_mutex);
+    while (!self->_should_exit) {
+        // the oldest request that is allowed to run now, or the time the first one is allowed
+        auto now = std::chrono::steady_clock::now();
+        auto next_ready = std::chrono::steady_clock::time_point::max();
+        std::map<std::string, Slot>::iterator ready = self->_slots.end();
+        for (auto it = self->_slots.begin(); it != self->_slots.end(); it++) {
+            const Slot &slot = it->second;
+            if (!slot.pending) {
+                continue;
+            }
+            auto slot_ready = slot.last_apply + self->_min_interval;
+            if (slot_ready > now) {
+                next_ready = std::min(next_ready, slot_ready);
+            } else if (ready == self->_slots.end() || slot.sequence < ready->second.sequence) {
+                ready = it;
+            }
+        }
+        if (ready == self->_slots.end()) {
+            if (next_ready == std::chrono::steady_clock::time_point::max()) {
+                self->_cv.wait(lock);
+            } else {
+                self->_cv.wait_until(lock, next_ready);
+            }
+            continue;
+        }
+
+        Slot &slot = ready->second;
+        auto apply = std::move(slot.pending);
+        slot.pending = nullptr;
+        slot.answer = nullptr;
+        std::vector<Answer> superseded;
+        superseded.swap(slot.superseded);
+        slot.last_apply = now;
+        if (slot.dropped > 0) {
+            base::LogDebug() << "Coalesced " << slot.dropped << " requests of " << ready->first;
+            slot.dropped = 0;
+        }
+        lock.unlock();
+        {
+            base::HeartbeatScope heartbeat("control_coalescer");
+            bool applied = apply();
+            for (auto &answer : superseded) {
+                answer(applied);
+            }
+        }
+        lock.lock();
+    }
+}
+
+}  // namespace mavcam
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace mavcam {
+
+/**
+ * @brief Latest wins queue for continuous camera controls
+ * @details Every control owns one slot holding the newest request, a request replaces the one
+ * still waiting in its slot. A worker thread applies slots in order of arrival, at most once per
+ * min interval for each control, so a dragged slider never builds up a backlog on the camera.
+ */
+class ControlCoalescer final {
+public:
+    using Apply = std::function<void()>;
+    /**
+     * @param applied result of the request that replaced this one
+     */
+    using Answer = std::function<void(bool applied)>;
+public:
+    explicit ControlCoalescer(std::chrono::milliseconds min_interval);
+    ~ControlCoalescer();
+public:
+    void start();
+    /**
+     * @brief stop worker thread, requests still waiting are dropped
+     */
+    void stop();
+    /**
+     * @brief queue the newest request of a control
+     * @param control name of the slot
+     * @param apply applies the value and acknowledges it, runs on worker thread
+     */
+    void submit(const std::string &control, Apply apply);
+    /**
+     * @brief same as above for requests the sender waits an answer for
+     * @param apply applies the value, acknowledges it and returns false on failure
+     * @param superseded answers this request if a newer one replaced it, runs on worker thread
+     * after the newer one was applied, so the answer reports the applied value
+     */
+    void submit(const std::string &control, std::function<bool()> apply, Answer superseded);
+private:
+    struct Slot {
+        std::function<bool()> pending{};
+        Answer answer{};                   ///< of the pending request
+        std::vector<Answer> superseded{};  ///< answers of replaced requests
+        uint64_t sequence{0};              ///< arrival order of pending request
+        uint32_t dropped{0};               ///< requests replaced before being applied
+        std::chrono::steady_clock::time_point last_apply{};
+    };
+private:
+    static void work_thread(ControlCoalescer *self);
+private:
+    const std::chrono::milliseconds _min_interval;
+    std::mutex _mutex{};
+    std::condition_variable _cv{};
+    std::map<std::string, Slot> _slots{};
+    uint64_t _sequence{0};
+    std::thread *_work_thread{nullptr};
+    bool _should_exit{false};
+};
+
+}  // namespace mavcam
@@ -4,37 +4,61 @@
 #include <mavsdk/mavsdk.h>
 #include <mavsdk/plugins/camera_server/camera_server.h>
 #include <mavsdk/plugins/ftp_server/ftp_server.h>
+#include <mavsdk/plugins/mavlink_passthrough/mavlink_passthrough.h>
 #include <mavsdk/plugins/param_server/param_server.h>
+#include <mavsdk/plugins/telemetry/telemetry.h>
 
 #include <chrono>
 #include <filesystem>
-#include <fstream>
 #include <iomanip>  // for std::setprecision
 #include <thread>
 
+#include "base/heartbeat.h"
 #include "base/log.h"
+#include "base/log_rate_limiter.h"
+#include "base/log_sink.h"
+#include "base/startup_profiler.h"
 #include "camera_client.h"
+#include "camera_settings.h"
 #include "led_control/led_control.h"
 
 namespace mavcam {
 
+// MAVSDK runs every callback on the same thread, a callback that never returns blocks all commands
+static const char *kCallbackHeartbeat = "mavsdk_callback";
+// params kept by mav_client itself, the camera never sees them
+static constexpr settings::SettingMask kClientParams =
+    settings::setting_mask(settings::SettingId::CamBurst) |
+    settings::setting_mask(settings::SettingId::CamSurveyDist);
+// MAV_CMD_IMAGE_START_CAPTURE, key of take photo repeats
+// polls inside this window are answered from the last sample
+static constexpr auto kPollWindow = std::chrono::milliseconds(200);
+
+MavClient::~MavClient() {
+    // camera client flushes persistent settings and closes camera
+    if (_camera_client != nullptr) {
+        delete _camera_client;
+        _camera_client = nullptr;
+    }
+    if (_mavsdk_log_sink != nullptr) {
+        _mavsdk_log_sink->close();
+    }
+}
+
 bool MavClient::init(std::string &connection_url, bool use_local, int32_t rpc_port,
-                     std::string &ftp_root_path, bool compatible_qgc, std::string &log_path) {
+                     std::string &ftp_root_path, bool compatible_qgc, std::string &log_path,
+                     size_t log_max_size, size_t log_max_files) {
     // TODO need check connection url first
     _connection_url = connection_url;
     _rpc_port = rpc_port;
     _ftp_root_path = ftp_root_path;
     _compatible_qgc = compatible_qgc;
 
-    init_mavsdk_log(log_path);
-    if (use_local) {
-        _camera_client = CreateLocalCameraClient();  // use local client
-    } else {
-        _camera_client = CreateRpcCameraClient(_rpc_port);  // use rpc client
-    }
-    if (_camera_client == nullptr) {
-        return false;
-    }
+    _use_local = use_local;
+
+    init_mavsdk_log(log_path, log_max_size, log_max_files);
+    // camera client is created by start_runloop() in background, so the camera component is
+    // visible while the camera still initializes
     return true;
 }
 
@@ -44,6 +68,7 @@ bool MavClient::start_runloop() {
         component_type = mavsdk::Mavsdk::ComponentType::Autopilot;
     }
     auto configuration = mavsdk::Mavsdk::Configuration{component_type};
+    base::StartupPhase connection_phase("mavsdk_connection");
     mavsdk::Mavsdk mavsdk{configuration};
     mavsdk.set_timeout_s(5);
 
@@ -62,239 +87,784 @@ bool MavClient::start_runloop() {
     }
     auto camera_server = mavsdk::CameraServer{camera_component};
     auto param_server = mavsdk::ParamServer{camera_component};
+    create_status_topics(camera_server);
+    _coalescer.start();
+    _executor.start();
+    _capture_pipeline.start(
+        [this](int32_t index) {
+            return _camera_client->take_photo(index) == mavsdk::CameraServer::Result::Success;
+        },
+        [this, &camera_server](const CapturePipeline::Capture &capture) {
+            report_capture(camera_server, capture);
+        });
     subscribe_camera_operation(camera_server, param_server);
     subscribe_param_operation(param_server);
+    std::shared_ptr<mavsdk::Telemetry> telemetry;
+    auto new_system_handle = mavsdk.subscribe_on_new_system([this, &mavsdk, &telemetry]() {
+        create_passthrough(mavsdk);
+        subscribe_position(mavsdk, telemetry);
+    });
     auto ftp_server = mavsdk::FtpServer{camera_component};
     ftp_server.set_root_dir(_ftp_root_path);
     base::LogInfo() << "Launch ftp server with root path " << _ftp_root_path;
+    connection_phase.stop();
 
-    switch_led_mode(LedMode::Normal);
     _running.store(true, std::memory_order_release);
+    std::thread camera_init_thread([this, &camera_server, &param_server]() {
+        init_camera_client(camera_server, param_server);
+    });
     while (_running.load(std::memory_order_consume)) {
         std::this_thread::sleep_for(std::chrono::milliseconds(500));
     }
     base::LogDebug() << "quit run loop";
-    return true;
+    mavsdk.unsubscribe_on_new_system(new_system_handle);
+    _survey_trigger.set_distance(0.0f);
+    // camera init and pending requests refer to the servers of this scope
+    camera_init_thread.join();
+    _status_publisher.stop();
+    _capture_pipeline.stop();
+    _executor.stop();
+    _coalescer.stop();
+    {
+        // sends through mavsdk of this scope
+        std::lock_guard<std::mutex> lock(_passthrough_mutex);
+        if (_passthrough != nullptr) {
+            _passthrough->intercept_incoming_messages_async(nullptr);
+            _passthrough.reset();
+        }
+    }
+    // topics send through camera server of this scope
+    _capture_status_topic.reset();
+    _storage_topic.reset();
+    _settings_topic.reset();
+    return _camera_client != nullptr;
 }
 
 void MavClient::stop_runloop() {
     _running.store(false, std::memory_order_release);
 }
 
+void MavClient::init_camera_client(mavsdk::CameraServer &camera_server,
+                                   mavsdk::ParamServer &param_server) {
+    base::StartupPhase client_phase("camera_client");
+    auto start = std::chrono::steady_clock::now();
+    if (_use_local) {
+        _camera_client = CreateLocalCameraClient();  // use local client
+    } else {
+        _camera_client = CreateRpcCameraClient(_rpc_port);  // use rpc client
+    }
+    if (_camera_client == nullptr) {
+        base::LogError() << "Cannot init camera client";
+        stop_runloop();
+        return;
+    }
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+    base::LogInfo() << "Camera client ready in " << duration.count() << " ms";
+    _camera_ready.store(true, std::memory_order_release);
+    client_phase.stop();
+
+    base::StartupPhase param_phase("fill_param");
+    fill_param(param_server);
+    param_phase.stop();
+
+    // Finally call set_information() to "activate" the camera plugin.
+    base::StartupPhase information_phase("set_information");
+    mavsdk::CameraServer::Information information;
+    _camera_client->fill_information(information);
+    auto ret = camera_server.set_information(information);
+    if (ret != mavsdk::CameraServer::Result::Success) {
+        base::LogError() << "Failed to set camera info";
+    }
+
+    // fill video stream info
+    std::vector<mavsdk::CameraServer::VideoStreamInfo> video_stream_infos;
+    _camera_client->fill_video_stream_info(video_stream_infos);
+    if (video_stream_infos.size() > 0) {
+        ret = camera_server.set_video_stream_info(video_stream_infos);
+    }
+    information_phase.stop();
+    switch_led_mode(LedMode::Normal);
+    _status_publisher.start(_status_interval);
+    base::StartupProfiler::instance().finish();
+}
+
+void MavClient::create_status_topics(mavsdk::CameraServer &camera_server) {
+    _capture_status_topic = std::make_unique<PublishedState<mavsdk::CameraServer::CaptureStatus>>(
+        [this](mavsdk::CameraServer::CaptureStatus &capture_status) {
+            fill_capture_status(capture_status);
+        },
+        [&camera_server](const mavsdk::CameraServer::CaptureStatus &capture_status) {
+            camera_server.respond_capture_status(mavsdk::CameraServer::CameraFeedback::Ok,
+                                                 capture_status);
+        });
+    _storage_topic = std::make_unique<PublishedState<mavsdk::CameraServer::StorageInformation>>(
+        [this](mavsdk::CameraServer::StorageInformation &storage_information) {
+            _camera_client->fill_storage_information(storage_information);
+        },
+        [&camera_server](const mavsdk::CameraServer::StorageInformation &storage_information) {
+            camera_server.respond_storage_information(mavsdk::CameraServer::CameraFeedback::Ok,
+                                                      storage_information);
+        });
+    _settings_topic = std::make_unique<PublishedState<mavsdk::CameraServer::Settings>>(
+        [this](mavsdk::CameraServer::Settings &settings) {
+            _camera_client->fill_settings(settings);
+        },
+        [&camera_server](const mavsdk::CameraServer::Settings &settings) {
+            camera_server.respond_settings(settings);
+        });
+    _status_publisher.add(_capture_status_topic.get());
+    _status_publisher.add(_storage_topic.get());
+    _status_publisher.add(_settings_topic.get());
+}
+
 void MavClient::subscribe_camera_operation(mavsdk::CameraServer &camera_server,
                                            mavsdk::ParamServer &param_server) {
-    camera_server.subscribe_system_time(
-        [this](int64_t time_unix_msec) { _camera_client->set_timestamp(time_unix_msec); });
+    // camera operations run on the executor lanes and respond once done, so this thread is free
+    // for the next message. Commands arriving before camera client is ready are answered busy.
+    camera_server.subscribe_system_time([this](int64_t time_unix_msec) {
+        base::HeartbeatScope heartbeat(kCallbackHeartbeat);
+        post_command(CommandExecutor::Lane::Settings, [this, time_unix_msec]() {
+            _camera_client->set_timestamp(time_unix_msec);
+        });
+    });
 
     camera_server.subscribe_zoom_range([this, &camera_server](float range) {
-        auto result = _camera_client->set_zoom_range(range);
-        if (result != mavsdk::CameraServer::Result::Success) {
-            camera_server.respond_zoom_range(mavsdk::CameraServer::CameraFeedback::Failed);
-        } else {
-            camera_server.respond_zoom_range(mavsdk::CameraServer::CameraFeedback::Ok);
+        base::HeartbeatScope heartbeat(kCallbackHeartbeat);
+        if (!camera_ready()) {
+            camera_server.respond_zoom_range(mavsdk::CameraServer::CameraFeedback::Busy);
+            return;
         }
+        // only the newest zoom is applied, every replaced request is answered with its result
+        auto respond = [&camera_server](bool applied) {
+            camera_server.respond_zoom_range(applied
+                                                 ? mavsdk::CameraServer::CameraFeedback::Ok
+                                                 : mavsdk::CameraServer::CameraFeedback::Failed);
+        };
+        _coalescer.submit(
+            "zoom",
+            [this, respond, range]() {
+                bool applied =
+                    _camera_client->set_zoom_range(range) == mavsdk::CameraServer::Result::Success;
+                respond(applied);
+                return applied;
+            },
+            respond);
     });
 
     camera_server.subscribe_take_photo([this, &camera_server](int32_t index) {
-        _camera_client->take_photo(index);
-
-        // TODO no position info for now
-        auto position = mavsdk::CameraServer::Position{};
-        auto attitude = mavsdk::CameraServer::Quaternion{};
-
-        auto timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
-                             std::chrono::system_clock::now().time_since_epoch())
-                             .count();
-        auto success = true;
-        camera_server.respond_take_photo(mavsdk::CameraServer::CameraFeedback::Ok,
-                                         mavsdk::CameraServer::CaptureInfo{
-                                             .position = position,
-                                             .attitude_quaternion = attitude,
-                                             .time_utc_us = static_cast<uint64_t>(timestamp),
-                                             .is_success = success,
-                                             .index = index,
-                                             .file_url = {},
-                                         });
-
-        // the qgc use capture status to change the take photo status
-        mavsdk::CameraServer::CaptureStatus capture_status;
-        _camera_client->fill_capture_status(capture_status);
-        camera_server.respond_capture_status(mavsdk::CameraServer::CameraFeedback::Ok,
-                                             capture_status);
+        base::HeartbeatScope heartbeat(kCallbackHeartbeat);
+        // repeated single photo commands never get here, see accept_take_photo()
+        // capture status shows a photo in progress until the pipeline has reported the last one
+        camera_server.set_in_progress(true);
+        CapturePipeline::Origin origin;
+        origin.requested = std::chrono::steady_clock::now();
+        origin.command = true;
+        origin.sequence = index;
+        origin.sender = take_single_capture(index);
+        if (!camera_ready() ||
+            !_capture_pipeline.submit(_burst_shots.load(std::memory_order_relaxed), origin)) {
+            if (origin.sender != 0) {
+                _command_dedup.forget(origin.sender, MAV_CMD_IMAGE_START_CAPTURE, index);
+            }
+            if (!_capture_pipeline.busy()) {
+                camera_server.set_in_progress(false);
+            }
+            mavsdk::CameraServer::CaptureInfo capture_info{};
+            capture_info.index = index;
+            camera_server.respond_take_photo(mavsdk::CameraServer::CameraFeedback::Busy,
+                                             capture_info);
+        }
     });
 
     camera_server.subscribe_start_video([this, &camera_server](int32_t stream_id) {
-        auto result = _camera_client->start_video();
-        if (result != mavsdk::CameraServer::Result::Success) {
-            camera_server.respond_start_video(mavsdk::CameraServer::CameraFeedback::Failed);
-        } else {
-            camera_server.respond_start_video(mavsdk::CameraServer::CameraFeedback::Ok);
+        base::HeartbeatScope heartbeat(kCallbackHeartbeat);
+        bool posted = post_command(CommandExecutor::Lane::Capture, [this, &camera_server]() {
+            auto result = _camera_client->start_video();
+            _capture_status_topic->invalidate();
+            if (result != mavsdk::CameraServer::Result::Success) {
+                camera_server.respond_start_video(mavsdk::CameraServer::CameraFeedback::Failed);
+            } else {
+                camera_server.respond_start_video(mavsdk::CameraServer::CameraFeedback::Ok);
+            }
+        });
+        if (!posted) {
+            camera_server.respond_start_video(mavsdk::CameraServer::CameraFeedback::Busy);
         }
     });
 
     camera_server.subscribe_stop_video([this, &camera_server](int32_t stream_id) {
-        auto result = _camera_client->stop_video();
-        if (result != mavsdk::CameraServer::Result::Success) {
-            camera_server.respond_stop_video(mavsdk::CameraServer::CameraFeedback::Failed);
-        } else {
-            camera_server.respond_stop_video(mavsdk::CameraServer::CameraFeedback::Ok);
+        base::HeartbeatScope heartbeat(kCallbackHeartbeat);
+        bool posted = post_command(CommandExecutor::Lane::Capture, [this, &camera_server]() {
+            auto result = _camera_client->stop_video();
+            _capture_status_topic->invalidate();
+            if (result != mavsdk::CameraServer::Result::Success) {
+                camera_server.respond_stop_video(mavsdk::CameraServer::CameraFeedback::Failed);
+            } else {
+                camera_server.respond_stop_video(mavsdk::CameraServer::CameraFeedback::Ok);
+            }
+        });
+        if (!posted) {
+            camera_server.respond_stop_video(mavsdk::CameraServer::CameraFeedback::Busy);
         }
     });
 
     camera_server.subscribe_start_video_streaming([this, &camera_server](int32_t stream_id) {
-        auto result = _camera_client->start_video_streaming(stream_id);
-        if (result != mavsdk::CameraServer::Result::Success) {
-            camera_server.respond_start_video_streaming(
-                mavsdk::CameraServer::CameraFeedback::Failed);
-        } else {
-            camera_server.respond_start_video_streaming(mavsdk::CameraServer::CameraFeedback::Ok);
+        base::HeartbeatScope heartbeat(kCallbackHeartbeat);
+        bool posted =
+            post_command(CommandExecutor::Lane::Capture, [this, &camera_server, stream_id]() {
+                auto result = _camera_client->start_video_streaming(stream_id);
+                if (result != mavsdk::CameraServer::Result::Success) {
+                    camera_server.respond_start_video_streaming(
+                        mavsdk::CameraServer::CameraFeedback::Failed);
+                } else {
+                    camera_server.respond_start_video_streaming(
+                        mavsdk::CameraServer::CameraFeedback::Ok);
+                }
+            });
+        if (!posted) {
+            camera_server.respond_start_video_streaming(mavsdk::CameraServer::CameraFeedback::Busy);
         }
     });
 
     camera_server.subscribe_stop_video_streaming([this, &camera_server](int32_t stream_id) {
-        auto result = _camera_client->stop_video_streaming(stream_id);
-        if (result != mavsdk::CameraServer::Result::Success) {
-            camera_server.respond_stop_video_streaming(
-                mavsdk::CameraServer::CameraFeedback::Failed);
-        } else {
-            camera_server.respond_stop_video_streaming(mavsdk::CameraServer::CameraFeedback::Ok);
+        base::HeartbeatScope heartbeat(kCallbackHeartbeat);
+        bool posted =
+            post_command(CommandExecutor::Lane::Capture, [this, &camera_server, stream_id]() {
+                auto result = _camera_client->stop_video_streaming(stream_id);
+                if (result != mavsdk::CameraServer::Result::Success) {
+                    camera_server.respond_stop_video_streaming(
+                        mavsdk::CameraServer::CameraFeedback::Failed);
+                } else {
+                    camera_server.respond_stop_video_streaming(
+                        mavsdk::CameraServer::CameraFeedback::Ok);
+                }
+            });
+        if (!posted) {
+            camera_server.respond_stop_video_streaming(mavsdk::CameraServer::CameraFeedback::Busy);
         }
     });
 
-    camera_server.subscribe_set_mode([this, &camera_server](mavsdk::CameraServer::Mode mode) {
-        auto result = _camera_client->set_mode(mode);
-        if (result != mavsdk::CameraServer::Result::Success) {
-            camera_server.respond_set_mode(mavsdk::CameraServer::CameraFeedback::Failed);
-        } else {
-            camera_server.respond_set_mode(mavsdk::CameraServer::CameraFeedback::Ok);
+    camera_server.subscribe_set_mode([this, &camera_server,
+                                      &param_server](mavsdk::CameraServer::Mode mode) {
+        base::HeartbeatScope heartbeat(kCallbackHeartbeat);
+        bool posted =
+            post_command(CommandExecutor::Lane::Settings, [this, &camera_server, &param_server,
+                                                           mode]() {
+                auto result = _camera_client->set_mode(mode);
+                _settings_topic->invalidate();
+                refresh_param(param_server, settings::SettingId::CamMode);
+                if (result != mavsdk::CameraServer::Result::Success) {
+                    camera_server.respond_set_mode(mavsdk::CameraServer::CameraFeedback::Failed);
+                } else {
+                    camera_server.respond_set_mode(mavsdk::CameraServer::CameraFeedback::Ok);
+                }
+            });
+        if (!posted) {
+            camera_server.respond_set_mode(mavsdk::CameraServer::CameraFeedback::Busy);
         }
     });
 
     camera_server.subscribe_storage_information([this, &camera_server](int32_t storage_id) {
-        mavsdk::CameraServer::StorageInformation storage_information;
-        _camera_client->fill_storage_information(storage_information);
-        camera_server.respond_storage_information(mavsdk::CameraServer::CameraFeedback::Ok,
-                                                  storage_information);
+        base::HeartbeatScope heartbeat(kCallbackHeartbeat);
+        if (camera_ready() && _storage_topic->respond_cached(kPollWindow)) {
+            return;
+        }
+        bool posted = post_command(CommandExecutor::Lane::Query,
+                                   [this]() { _storage_topic->respond(); });
+        if (!posted) {
+            camera_server.respond_storage_information(mavsdk::CameraServer::CameraFeedback::Busy,
+                                                      {});
+        }
     });
 
     camera_server.subscribe_capture_status([this, &camera_server](int32_t reserved) {
-        base::LogDebug() << "respond capture status";
-        mavsdk::CameraServer::CaptureStatus capture_status;
-        _camera_client->fill_capture_status(capture_status);
-        camera_server.respond_capture_status(mavsdk::CameraServer::CameraFeedback::Ok,
-                                             capture_status);
+        base::HeartbeatScope heartbeat(kCallbackHeartbeat);
+        if (camera_ready() && _capture_status_topic->respond_cached(kPollWindow)) {
+            return;
+        }
+        bool posted = post_command(CommandExecutor::Lane::Query, [this]() {
+            base::LogDebug() << "respond capture status";
+            _capture_status_topic->respond();
+        });
+        if (!posted) {
+            camera_server.respond_capture_status(mavsdk::CameraServer::CameraFeedback::Busy, {});
+        }
     });
 
     camera_server.subscribe_format_storage([this, &camera_server](int storage_id) {
-        auto result = _camera_client->format_storage(storage_id);
-        camera_server.respond_format_storage(mavsdk::CameraServer::CameraFeedback::Ok);
+        base::HeartbeatScope heartbeat(kCallbackHeartbeat);
+        bool posted =
+            post_command(CommandExecutor::Lane::Capture, [this, &camera_server, storage_id]() {
+                auto result = _camera_client->format_storage(storage_id);
+                _storage_topic->invalidate();
+                _capture_status_topic->invalidate();
+                camera_server.respond_format_storage(mavsdk::CameraServer::CameraFeedback::Ok);
+            });
+        if (!posted) {
+            camera_server.respond_format_storage(mavsdk::CameraServer::CameraFeedback::Busy);
+        }
     });
 
     camera_server.subscribe_reset_settings([this, &camera_server, &param_server](int camera_id) {
-        auto result = _camera_client->reset_settings();
-        //reset settings need fill param again
-        fill_param(param_server);
-        camera_server.respond_reset_settings(mavsdk::CameraServer::CameraFeedback::Ok);
+        base::HeartbeatScope heartbeat(kCallbackHeartbeat);
+        bool posted =
+            post_command(CommandExecutor::Lane::Settings, [this, &camera_server, &param_server]() {
+                auto result = _camera_client->reset_settings();
+                {
+                    // fill_param() provides the defaults of client params again
+                    std::lock_guard<std::mutex> lock(_param_mutex);
+                    for (const auto &info : settings::kSettings) {
+                        if ((kClientParams & settings::setting_mask(info.id)) != 0) {
+                            _param_values[info.id].clear();
+                        }
+                    }
+                }
+                _settings_topic->invalidate();
+                //reset settings need fill param again
+                fill_param(param_server);
+                camera_server.respond_reset_settings(mavsdk::CameraServer::CameraFeedback::Ok);
+            });
+        if (!posted) {
+            camera_server.respond_reset_settings(mavsdk::CameraServer::CameraFeedback::Busy);
+        }
     });
 
     camera_server.subscribe_settings([this, &camera_server](int reserved) {
-        mavsdk::CameraServer::Settings settings;
-        auto result = _camera_client->fill_settings(settings);
-        camera_server.respond_settings(settings);
+        base::HeartbeatScope heartbeat(kCallbackHeartbeat);
+        if (camera_ready() && _settings_topic->respond_cached(kPollWindow)) {
+            return;
+        }
+        post_command(CommandExecutor::Lane::Query, [this]() { _settings_topic->respond(); });
     });
-    // Then set the initial state of everything.
-
-    // Finally call set_information() to "activate" the camera plugin.
-    mavsdk::CameraServer::Information information;
-    _camera_client->fill_information(information);
-    auto ret = camera_server.set_information(information);
-    if (ret != mavsdk::CameraServer::Result::Success) {
-        base::LogError() << "Failed to set camera info";
-    }
-
-    // fill video stream info
-    std::vector<mavsdk::CameraServer::VideoStreamInfo> video_stream_infos;
-    _camera_client->fill_video_stream_info(video_stream_infos);
-    if (video_stream_infos.size() > 0) {
-        ret = camera_server.set_video_stream_info(video_stream_infos);
-    }
+    // information is set once camera client is ready, see init_camera_client()
 }
 
 void MavClient::subscribe_param_operation(mavsdk::ParamServer &param_server) {
-    param_server.subscribe_changed_param_float([this](mavsdk::ParamServer::FloatParam float_param) {
-        base::LogDebug() << "param server change float " << float_param.name << " to "
-                         << float_param.value;
-        mavsdk::Camera::Setting setting;
-        setting.setting_id = float_param.name;
-        setting.option.option_id = std::to_string(float_param.value);
-        _camera_client->set_setting(setting);
-    });
-    param_server.subscribe_changed_param_int([this](mavsdk::ParamServer::IntParam int_param) {
-        base::LogDebug() << "param server change int " << int_param.name << " to "
-                         << int_param.value;
-        mavsdk::Camera::Setting setting;
-        setting.setting_id = int_param.name;
-        setting.option.option_id = std::to_string(int_param.value);
+    param_server.subscribe_changed_param_float(
+        [this, &param_server](mavsdk::ParamServer::FloatParam float_param) {
+            base::HeartbeatScope heartbeat(kCallbackHeartbeat);
+            base::LogDebug() << "param server change float " << float_param.name << " to "
+                             << float_param.value;
+            change_param(param_server, float_param.name, std::to_string(float_param.value));
+        });
+    param_server.subscribe_changed_param_int(
+        [this, &param_server](mavsdk::ParamServer::IntParam int_param) {
+            base::HeartbeatScope heartbeat(kCallbackHeartbeat);
+            base::LogDebug() << "param server change int " << int_param.name << " to "
+                             << int_param.value;
+            change_param(param_server, int_param.name, std::to_string(int_param.value));
+        });
+    // params are provided once camera client is ready, see init_camera_client()
+}
+
+void MavClient::change_param(mavsdk::ParamServer &param_server, const std::string &name,
+                             const std::string &value) {
+    if (!camera_ready()) {
+        base::LogWarn() << "Ignore " << name << " change, camera is not ready";
+        return;
+    }
+    // params driven by sliders on the ground station
+    static constexpr settings::SettingMask kContinuousParams =
+        settings::setting_mask(settings::SettingId::CamEv) |
+        settings::setting_mask(settings::SettingId::CamIso) |
+        settings::setting_mask(settings::SettingId::CamShutterspd);
+
+    mavsdk::Camera::Setting setting;
+    setting.setting_id = name;
+    setting.option.option_id = value;
+    settings::SettingId id;
+    if (!settings::find_setting(name, id)) {
+        _executor.post(CommandExecutor::Lane::Settings,
+                       [this, setting]() { _camera_client->set_setting(setting); });
+        return;
+    }
+    if ((kClientParams & settings::setting_mask(id)) != 0) {
+        std::lock_guard<std::mutex> lock(_param_mutex);
+        if (settings::find_option(id, value) != nullptr) {
+            provide_param(param_server, id, value, true);
+            apply_client_param(id, value);
+        } else {
+            base::LogWarn() << "Ignore " << name << " " << value << ", not an option";
+            provide_param(param_server, id, _param_values[id], true);
+        }
+        return;
+    }
+    auto apply = [this, &param_server, setting, id]() {
         _camera_client->set_setting(setting);
-    });
+        // pushes the value the camera actually took
+        refresh_param(param_server, id);
+    };
+    if ((kContinuousParams & settings::setting_mask(id)) != 0) {
+        // e.g. an ev change depends on an exposure mode change sent before it
+        uint64_t ticket = _executor.ticket(CommandExecutor::Lane::Settings);
+        _coalescer.submit(name, [this, apply, ticket]() {
+            _executor.wait_done(CommandExecutor::Lane::Settings, ticket);
+            apply();
+        });
+    } else if (!_executor.post(CommandExecutor::Lane::Settings, apply)) {
+        // the param server keeps the requested value, push back the one provided last, reading
+        // the camera would block this thread
+        std::lock_guard<std::mutex> lock(_param_mutex);
+        if (_param_values.contains(id)) {
+            provide_param(param_server, id, _param_values[id], true);
+        }
+    }
+}
 
-    fill_param(param_server);
+bool MavClient::post_command(CommandExecutor::Lane lane, CommandExecutor::Command command) {
+    return camera_ready() && _executor.post(lane, std::move(command));
 }
 
 void MavClient::fill_param(mavsdk::ParamServer &param_server) {
     std::vector<mavsdk::Camera::Setting> settings;
     _camera_client->retrieve_current_settings(settings);
 
+    // one fill param line for each param
+    base::log::RateLimitExemptScope exempt;
+    std::lock_guard<std::mutex> lock(_param_mutex);
     for (auto &setting : settings) {
-        base::LogDebug() << "fill param " << setting.setting_id
-                         << " to value: " << setting.option.option_id;
-        // TODO hard code
-        if (setting.setting_id == "CAM_SHUTTERSPD" || setting.setting_id == "CAM_EV") {
-            param_server.provide_param_float(setting.setting_id,
-                                             std::stof(setting.option.option_id));
+        settings::SettingId id;
+        if (!settings::find_setting(setting.setting_id, id)) {
+            base::LogWarn() << "Ignore unknown param " << setting.setting_id;
+            continue;
+        }
+        provide_param(param_server, id, setting.option.option_id, false);
+    }
+    for (const auto &info : settings::kSettings) {
+        if ((kClientParams & settings::setting_mask(info.id)) != 0 &&
+            !_param_values.contains(info.id)) {
+            provide_param(param_server, info.id, info.default_value, false);
+            apply_client_param(info.id, info.default_value);
+        }
+    }
+}
+
+void MavClient::apply_client_param(settings::SettingId id, const std::string &value) {
+    if (id == settings::SettingId::CamBurst) {
+        // only options of the definition get here, see change_param()
+        _burst_shots.store(static_cast<uint32_t>(std::stoul(value)), std::memory_order_relaxed);
+    } else if (id == settings::SettingId::CamSurveyDist) {
+        _survey_trigger.set_distance(std::stof(value));
+    }
+}
+
+void MavClient::subscribe_position(mavsdk::Mavsdk &mavsdk,
+                                   std::shared_ptr<mavsdk::Telemetry> &telemetry) {
+    if (telemetry != nullptr) {
+        return;
+    }
+    for (auto &system : mavsdk.systems()) {
+        if (!system->has_autopilot()) {
+            continue;
+        }
+        telemetry = std::make_shared<mavsdk::Telemetry>(system);
+        // comes with every GLOBAL_POSITION_INT, so it only hands the position over
+        telemetry->subscribe_position([this](mavsdk::Telemetry::Position position) {
+            base::HeartbeatScope heartbeat(kCallbackHeartbeat);
+            _survey_trigger.on_position(SurveyTrigger::Position{
+                position.latitude_deg, position.longitude_deg, position.absolute_altitude_m,
+                position.relative_altitude_m});
+        });
+        base::LogInfo() << "Survey follows position of system "
+                        << static_cast<int>(system->get_system_id());
+        return;
+    }
+}
+
+void MavClient::create_passthrough(mavsdk::Mavsdk &mavsdk) {
+    std::lock_guard<std::mutex> lock(_passthrough_mutex);
+    if (_passthrough != nullptr || mavsdk.systems().empty()) {
+        return;
+    }
+    // a message of any system goes out on every connection, and every incoming message passes
+    // the interception
+    _passthrough = std::make_shared<mavsdk::MavlinkPassthrough>(mavsdk.systems().front());
+    _passthrough->intercept_incoming_messages_async([this](mavlink_message_t &message) {
+        if (message.msgid != MAVLINK_MSG_ID_COMMAND_LONG) {
+            return true;
+        }
+        mavlink_command_long_t command;
+        mavlink_msg_command_long_decode(&message, &command);
+        // an interval capture calls take photo with its sequence on every tick, only single
+        // photo commands are checked for repeats
+        if (command.command != MAV_CMD_IMAGE_START_CAPTURE ||
+            static_cast<int32_t>(command.param3) != 1 ||
+            (command.target_component != MAV_COMP_ID_CAMERA && command.target_component != 0)) {
+            return true;
+        }
+        auto sender = static_cast<uint16_t>((message.sysid << 8) | message.compid);
+        return accept_take_photo(sender, static_cast<int32_t>(command.param4),
+                                 command.confirmation);
+    });
+}
+
+bool MavClient::accept_take_photo(uint16_t sender, int32_t index, uint8_t confirmation) {
+    if (index <= 0 && confirmation == 0) {
+        // qgc sends no sequence, only the confirmation tells a repeat from the next photo
+        _command_dedup.forget(sender, MAV_CMD_IMAGE_START_CAPTURE, index);
+    }
+    CommandDedup::Replay replay;
+    switch (_command_dedup.begin(sender, MAV_CMD_IMAGE_START_CAPTURE, index, replay)) {
+        case CommandDedup::State::Running:
+            base::LogDebug() << "Drop repeated take photo " << index << " of " << sender
+                             << ", still capturing";
+            return false;
+        case CommandDedup::State::Done:
+            base::LogDebug() << "Answer repeated take photo " << index << " of " << sender
+                             << " again";
+            replay();
+            return false;
+        case CommandDedup::State::New:
+            break;
+    }
+    std::lock_guard<std::mutex> lock(_single_capture_mutex);
+    if (_single_captures.size() >= kMaxSingleCaptures) {
+        _single_captures.pop_front();
+    }
+    _single_captures.push_back(SingleCapture{sender, index});
+    return true;
+}
+
+uint16_t MavClient::take_single_capture(int32_t index) {
+    std::lock_guard<std::mutex> lock(_single_capture_mutex);
+    for (auto it = _single_captures.begin(); it != _single_captures.end(); ++it) {
+        if (it->index == index) {
+            uint16_t sender = it->sender;
+            _single_captures.erase(it);
+            return sender;
+        }
+    }
+    return 0;
+}
+
+void MavClient::send_command_ack(uint16_t sender, uint16_t command) {
+    std::lock_guard<std::mutex> lock(_passthrough_mutex);
+    if (_passthrough == nullptr) {
+        return;
+    }
+    mavlink_message_t message;
+    mavlink_msg_command_ack_pack(_passthrough->get_our_sysid(), MAV_COMP_ID_CAMERA, &message,
+                                 command, MAV_RESULT_ACCEPTED, 0, 0,
+                                 static_cast<uint8_t>(sender >> 8),
+                                 static_cast<uint8_t>(sender & 0xff));
+    if (_passthrough->send_message(message) != mavsdk::MavlinkPassthrough::Result::Success) {
+        base::LogWarn() << "Send ack of command " << command << " to " << sender << " failed";
+    }
+}
+
+void MavClient::send_image_captured(const mavsdk::CameraServer::CaptureInfo &capture_info) {
+    std::lock_guard<std::mutex> lock(_passthrough_mutex);
+    if (_passthrough == nullptr) {
+        base::LogWarn() << "No system to send image " << capture_info.index << " to";
+        return;
+    }
+    // the same fields camera server fills for respond_take_photo()
+    const float attitude[4] = {
+        capture_info.attitude_quaternion.w, capture_info.attitude_quaternion.x,
+        capture_info.attitude_quaternion.y, capture_info.attitude_quaternion.z};
+    auto time_boot_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                            std::chrono::steady_clock::now().time_since_epoch())
+                            .count();
+    mavlink_message_t message;
+    mavlink_msg_camera_image_captured_pack(
+        _passthrough->get_our_sysid(), MAV_COMP_ID_CAMERA, &message,
+        static_cast<uint32_t>(time_boot_ms), capture_info.time_utc_us, 0,
+        static_cast<int32_t>(capture_info.position.latitude_deg * 1e7),
+        static_cast<int32_t>(capture_info.position.longitude_deg * 1e7),
+        static_cast<int32_t>(capture_info.position.absolute_altitude_m * 1e3f),
+        static_cast<int32_t>(capture_info.position.relative_altitude_m * 1e3f), attitude,
+        capture_info.index, capture_info.is_success ? 1 : 0, capture_info.file_url.c_str());
+    if (_passthrough->send_message(message) != mavsdk::MavlinkPassthrough::Result::Success) {
+        base::LogWarn() << "Send image " << capture_info.index << " failed";
+    }
+}
+
+bool MavClient::fire_survey(uint32_t sequence, const SurveyTrigger::Position &position,
+                            std::chrono::steady_clock::time_point time) {
+    if (!camera_ready()) {
+        return false;
+    }
+    CapturePipeline::Origin origin;
+    origin.requested = time;
+    origin.survey = true;
+    origin.latitude_deg = position.latitude_deg;
+    origin.longitude_deg = position.longitude_deg;
+    origin.absolute_altitude_m = position.absolute_altitude_m;
+    origin.relative_altitude_m = position.relative_altitude_m;
+    base::LogDebug() << "Fire survey photo " << sequence;
+    return _capture_pipeline.submit(1, origin);
+}
+
+void MavClient::report_capture(mavsdk::CameraServer &camera_server,
+                               const CapturePipeline::Capture &capture) {
+    // TODO position of photos the ground station asked for, no attitude for now
+    auto position = mavsdk::CameraServer::Position{};
+    auto attitude = mavsdk::CameraServer::Quaternion{};
+    if (capture.origin.survey) {
+        position.latitude_deg = capture.origin.latitude_deg;
+        position.longitude_deg = capture.origin.longitude_deg;
+        position.absolute_altitude_m = capture.origin.absolute_altitude_m;
+        position.relative_altitude_m = capture.origin.relative_altitude_m;
+        _survey_trigger.record_latency(capture.taken - capture.origin.requested);
+    }
+    auto capture_info = mavsdk::CameraServer::CaptureInfo{
+        .position = position,
+        .attitude_quaternion = attitude,
+        .time_utc_us = capture.time_utc_us,
+        .is_success = capture.success,
+        .index = capture.index,
+        .file_url = {},
+    };
+    if (capture.origin.command && capture.shot == 0) {
+        // also acks the last take photo command, so only the photo answering it goes this way
+        camera_server.respond_take_photo(mavsdk::CameraServer::CameraFeedback::Ok, capture_info);
+        uint16_t sender = capture.origin.sender;
+        if (sender != 0) {
+            // a repeat is dropped before camera server sees it, so it is answered directly
+            _command_dedup.finish(sender, MAV_CMD_IMAGE_START_CAPTURE, capture.origin.sequence,
+                                  [this, sender, capture_info]() {
+                                      send_command_ack(sender, MAV_CMD_IMAGE_START_CAPTURE);
+                                      send_image_captured(capture_info);
+                                  });
+        }
+    } else {
+        // survey photos and the rest of a burst, no command waits for them
+        send_image_captured(capture_info);
+    }
+    if (capture.last) {
+        camera_server.set_in_progress(false);
+    }
+    // the qgc use capture status to change the take photo status
+    _capture_status_topic->respond();
+}
+
+void MavClient::fill_capture_status(mavsdk::CameraServer::CaptureStatus &capture_status) {
+    _camera_client->fill_capture_status(capture_status);
+    if (_capture_pipeline.busy()) {
+        // photos taken back to back show as an interval capture at the achieved rate
+        float fps = _capture_pipeline.frames_per_second();
+        if (fps > 0.0f) {
+            capture_status.image_status =
+                mavsdk::CameraServer::CaptureStatus::ImageStatus::IntervalInProgress;
+            capture_status.image_interval_s = 1.0f / fps;
         } else {
-            auto result = param_server.provide_param_int(setting.setting_id,
-                                                         std::stoi(setting.option.option_id));
+            capture_status.image_status =
+                mavsdk::CameraServer::CaptureStatus::ImageStatus::CaptureInProgress;
+        }
+    }
+}
+
+void MavClient::refresh_param(mavsdk::ParamServer &param_server, settings::SettingId id) {
+    // the camera is read without _param_mutex, a read is a blocking rpc call in rpc mode
+    std::string value;
+    bool has_value = read_setting(id, value);
+    settings::SettingMask pending = 0;
+    {
+        std::lock_guard<std::mutex> lock(_param_mutex);
+        settings::SettingMask hidden_before = hidden_params();
+        // the param server holds the requested value even when the camera refused it, so the
+        // changed param is always pushed, its new value also decides which params are hidden
+        if (has_value) {
+            provide_param(param_server, id, value, true);
+        }
+        settings::SettingMask hidden = hidden_params();
+        pending = settings::setting_info(id).updates | (hidden_before & ~hidden);
+        pending &= ~hidden & ~settings::setting_mask(id);
+    }
+    std::vector<std::pair<settings::SettingId, std::string>> values;
+    for (const auto &info : settings::kSettings) {
+        if ((pending & settings::setting_mask(info.id)) != 0 && read_setting(info.id, value)) {
+            values.emplace_back(info.id, value);
         }
     }
+    std::lock_guard<std::mutex> lock(_param_mutex);
+    for (const auto &[pending_id, pending_value] : values) {
+        provide_param(param_server, pending_id, pending_value, false);
+    }
 }
 
-void MavClient::init_mavsdk_log(std::string &log_path) {
+bool MavClient::read_setting(settings::SettingId id, std::string &value) {
+    mavsdk::Camera::Setting setting;
+    setting.setting_id = settings::setting_name(id);
+    auto [result, current] = _camera_client->get_setting(setting);
+    if (result != mavsdk::CameraServer::Result::Success || current.option.option_id.empty()) {
+        base::LogWarn() << "Failed to read param " << setting.setting_id << " : " << result;
+        return false;
+    }
+    value = current.option.option_id;
+    return true;
+}
+
+void MavClient::provide_param(mavsdk::ParamServer &param_server, settings::SettingId id,
+                              const std::string &value, bool force) {
+    if (!force && _param_values[id] == value) {
+        return;
+    }
+    const char *name = settings::setting_name(id);
+    base::LogDebug() << "fill param " << name << " to value: " << value;
+    if (settings::setting_info(id).type == settings::SettingType::Float) {
+        param_server.provide_param_float(name, std::stof(value));
+    } else {
+        param_server.provide_param_int(name, std::stoi(value));
+    }
+    _param_values[id] = value;
+}
+
+settings::SettingMask MavClient::hidden_params() const {
+    settings::SettingMask hidden = 0;
+    for (const auto &info : settings::kSettings) {
+        if (_param_values.contains(info.id)) {
+            hidden |= settings::excluded_settings(info.id, _param_values[info.id]);
+        }
+    }
+    return hidden;
+}
+
+void MavClient::init_mavsdk_log(std::string &log_path, size_t log_max_size,
+                                size_t log_max_files) {
     std::string full_path = log_path + "mavsdk.log";
-    auto log_stream =
-        std::make_shared<std::fstream>(full_path, std::fstream::out | std::fstream::binary);
-    if (!log_stream->is_open()) {
+    auto log_sink = std::make_shared<base::AsyncLogSink>();
+    base::AsyncLogSink::Options options;
+    options.overflow_policy = base::AsyncLogSink::OverflowPolicy::Drop;
+    options.max_file_size = log_max_size;
+    options.max_files = log_max_files;
+    options.suppressed_interval = std::chrono::seconds(1);
+    options.suppressed_sites = base::LogRateLimiter::Sites::Keyed;
+    if (!log_sink->open(full_path, options)) {
         base::LogError() << "Failed to open mavsdk log file: " + full_path;
         return;
     }
-    mavsdk::log::subscribe([log_stream](mavsdk::log::Level level, const std::string &message,
-                                        const std::string &file, int line) -> bool {
-        std::stringstream ss;
-        time_t rawtime;
-        time(&rawtime);
-        struct tm *timeinfo = localtime(&rawtime);
-        char time_buffer[10]{};
-        strftime(time_buffer, sizeof(time_buffer), "%I:%M:%S", timeinfo);
-        ss << "[" << time_buffer;
+    _mavsdk_log_sink = log_sink;
+    mavsdk::log::subscribe([log_sink](mavsdk::log::Level level, const std::string &message,
+                                      const std::string &file, int line) -> bool {
+        base::log::Level log_level = base::log::Level::Debug;
         switch (level) {
             case mavsdk::log::Level::Debug:
-                ss << "|Debug] ";
+                log_level = base::log::Level::Debug;
                 break;
             case mavsdk::log::Level::Info:
-                ss << "|Info ] ";
+                log_level = base::log::Level::Info;
                 break;
             case mavsdk::log::Level::Warn:
-                ss << "|Warn ] ";
+                log_level = base::log::Level::Warn;
                 break;
             case mavsdk::log::Level::Err:
-                ss << "|Error] ";
+                log_level = base::log::Level::Err;
                 break;
         }
-        ss << " " << message << "\n";
-        if (log_stream->good()) {
-            log_stream->write(ss.str().c_str(), ss.str().size());
-            log_stream->flush();
+        // share the per call site budgets of base log, keyed by MAVSDK source location
+        uint64_t key = std::hash<std::string>()(file) * 31 + static_cast<uint64_t>(line);
+        uint32_t repeated = 0;
+        if (!base::log::get_rate_limiter().allow(log_level, key, repeated,
+                                                  {file.c_str(), line, 0})) {
+            return true;
+        }
+        if (repeated > 0) {
+            log_sink->push(log_level, std::to_string(repeated) + " messages suppressed at " +
+                                          file + ":" + std::to_string(line));
         }
+        log_sink->push(log_level, message);
         return false;
     });
 }
@@ -1,11 +1,31 @@
 #pragma once
 
+#include <mavsdk/plugins/camera_server/camera_server.h>
+
 #include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <string>
 
+#include "camera_settings.h"
+#include "capture_pipeline.h"
+#include "command_dedup.h"
+#include "command_executor.h"
+#include "control_coalescer.h"
+#include "status_publisher.h"
+#include "survey_trigger.h"
+
+namespace base {
+class AsyncLogSink;
+}  // namespace base
+
 namespace mavsdk {
-class CameraServer;
+class Mavsdk;
+class MavlinkPassthrough;
 class ParamServer;
+class Telemetry;
 }  // namespace mavsdk
 
 namespace mavcam {
@@ -15,25 +35,147 @@ class CameraClient;
 class MavClient {
 public:
     MavClient() {}
-    ~MavClient() {}
+    ~MavClient();
 public:
     bool init(std::string &connection_url, bool use_local, int32_t rpc_port,
-              std::string &ftp_root_path, bool compatible_qgc, std::string &log_path);
+              std::string &ftp_root_path, bool compatible_qgc, std::string &log_path,
+              size_t log_max_size, size_t log_max_files);
     bool start_runloop();
     void stop_runloop();
+    /**
+     * @brief how often capture status, storage and settings are checked for changes and pushed,
+     * 0 only answers polls, call before start_runloop()
+     */
+    void set_status_interval(std::chrono::milliseconds interval) { _status_interval = interval; }
+    /**
+     * @brief photos taken but not reported yet before take photo answers busy, call before
+     * start_runloop()
+     */
+    void set_capture_depth(size_t depth) { _capture_pipeline.set_max_in_flight(depth); }
 private:
     void subscribe_camera_operation(mavsdk::CameraServer &camera_server,
                                     mavsdk::ParamServer &param_server);
     void subscribe_param_operation(mavsdk::ParamServer &param_server);
+    /**
+     * @brief create camera client, then publish camera information and params
+     * @details runs beside the run loop, stops it when camera client cannot be created
+     */
+    void init_camera_client(mavsdk::CameraServer &camera_server,
+                            mavsdk::ParamServer &param_server);
+    /**
+     * @brief states pushed by the status publisher, they send through camera_server
+     */
+    void create_status_topics(mavsdk::CameraServer &camera_server);
+    bool camera_ready() const { return _camera_ready.load(std::memory_order_acquire); }
+    /**
+     * @brief apply a param change, continuous controls go through the coalescer
+     */
+    void change_param(mavsdk::ParamServer &param_server, const std::string &name,
+                      const std::string &value);
+    /**
+     * @brief queue a command once camera client is ready
+     * @return false when the command was not queued, the caller answers busy then
+     */
+    bool post_command(CommandExecutor::Lane lane, CommandExecutor::Command command);
     void fill_param(mavsdk::ParamServer &param_server);
-    void init_mavsdk_log(std::string &log_path);
+    /**
+     * @brief act on a param mav_client keeps itself, called with _param_mutex held
+     */
+    void apply_client_param(settings::SettingId id, const std::string &value);
+    /**
+     * @brief feed the survey trigger from the first autopilot, called when a system appears
+     */
+    void subscribe_position(mavsdk::Mavsdk &mavsdk, std::shared_ptr<mavsdk::Telemetry> &telemetry);
+    /**
+     * @brief sender of messages camera server has no call for, from the first system
+     */
+    void create_passthrough(mavsdk::Mavsdk &mavsdk);
+    /**
+     * @brief check a single photo command before camera server sees it, runs on the MAVSDK
+     * receive thread
+     * @return false when it is a repeat, dropped or answered again
+     */
+    bool accept_take_photo(uint16_t sender, int32_t index, uint8_t confirmation);
+    /**
+     * @brief sender of the single photo command accept_take_photo() passed on for index, 0 for
+     * the ticks of an interval capture
+     */
+    uint16_t take_single_capture(int32_t index);
+    /**
+     * @brief send an accepted COMMAND_ACK to sender, system id in the high byte
+     */
+    void send_command_ack(uint16_t sender, uint16_t command);
+    /**
+     * @brief send CAMERA_IMAGE_CAPTURED without answering a command
+     */
+    void send_image_captured(const mavsdk::CameraServer::CaptureInfo &capture_info);
+    /**
+     * @brief queue a survey photo on the capture pipeline
+     */
+    bool fire_survey(uint32_t sequence, const SurveyTrigger::Position &position,
+                     std::chrono::steady_clock::time_point time);
+    /**
+     * @brief send capture info of one photo of the capture pipeline, runs on its report thread
+     * @details the first photo of a take photo command answers it through respond take photo,
+     * survey photos and the other photos of a burst only send their capture info
+     */
+    void report_capture(mavsdk::CameraServer &camera_server,
+                        const CapturePipeline::Capture &capture);
+    /**
+     * @brief capture status of the camera with the photos of the capture pipeline in progress
+     */
+    void fill_capture_status(mavsdk::CameraServer::CaptureStatus &capture_status);
+    /**
+     * @brief read again the params a change of id may have touched and push the changed ones
+     * @details uses updates and exclusions of the camera definition, a param hidden by the
+     * current options is not read until it becomes visible again
+     */
+    void refresh_param(mavsdk::ParamServer &param_server, settings::SettingId id);
+    /**
+     * @brief current value of a setting from the camera client, may block in rpc mode
+     */
+    bool read_setting(settings::SettingId id, std::string &value);
+    void provide_param(mavsdk::ParamServer &param_server, settings::SettingId id,
+                       const std::string &value, bool force);
+    settings::SettingMask hidden_params() const;
+    void init_mavsdk_log(std::string &log_path, size_t log_max_size, size_t log_max_files);
 private:
     std::atomic<bool> _running;
     std::string _connection_url;
     int32_t _rpc_port;
-    CameraClient *_camera_client;
+    bool _use_local{true};
+    CameraClient *_camera_client{nullptr};  ///< set by init_camera_client()
+    std::atomic<bool> _camera_ready{false};
     std::string _ftp_root_path;
     bool _compatible_qgc;
+    std::shared_ptr<base::AsyncLogSink> _mavsdk_log_sink;
+    ControlCoalescer _coalescer{std::chrono::milliseconds(50)};
+    CommandExecutor _executor{8};
+    CapturePipeline _capture_pipeline{4};  ///< max photos taken but not reported yet
+    std::mutex _passthrough_mutex;
+    std::shared_ptr<mavsdk::MavlinkPassthrough> _passthrough;  ///< set by create_passthrough()
+    // longer than the retransmit timeout of a ground station
+    CommandDedup _command_dedup{std::chrono::seconds(3), 16};
+    struct SingleCapture {
+        uint16_t sender{0};
+        int32_t index{0};
+    };
+    static constexpr size_t kMaxSingleCaptures = 8;
+    std::mutex _single_capture_mutex;
+    std::deque<SingleCapture> _single_captures;  ///< accepted, take photo not called yet
+    std::chrono::milliseconds _status_interval{500};
+    StatusPublisher _status_publisher{std::chrono::seconds(5)};  ///< keepalive of unchanged state
+    std::unique_ptr<PublishedState<mavsdk::CameraServer::CaptureStatus>> _capture_status_topic;
+    std::unique_ptr<PublishedState<mavsdk::CameraServer::StorageInformation>> _storage_topic;
+    std::unique_ptr<PublishedState<mavsdk::CameraServer::Settings>> _settings_topic;
+    SurveyTrigger _survey_trigger{[this](uint32_t sequence, const SurveyTrigger::Position &position,
+                                         std::chrono::steady_clock::time_point time) {
+        return fire_survey(sequence, position, time);
+    }};
+    // never held across camera client calls, take photo and param callbacks wait for it
+    std::mutex _param_mutex;
+    settings::SettingValues _param_values{};  ///< values last provided to param server
+    std::atomic<uint32_t> _burst_shots{1};    ///< photos taken for one trigger, CAM_BURST
 };
 
 }  // namespace mavcam
@@ -1,11 +1,15 @@
+#include <algorithm>
 #include <csignal>
 #include <filesystem>
-#include <fstream>
 #include <iostream>
 #include <regex>
 
 #include "base/file_operation.h"
+#include "base/heartbeat.h"
 #include "base/log.h"
+#include "base/log_rate_limiter.h"
+#include "base/log_sink.h"
+#include "base/startup_profiler.h"
 #include "mav_client.h"
 #include "version.h"
 
@@ -15,10 +19,17 @@ static std::string default_ftp_path = "/usr/share/mav-cam/";
 static std::string default_log_path = "/data/camera/";
 static bool compatible_qgc = false;
 static std::string default_store_prefix = "NDAA";
+static std::shared_ptr<base::AsyncLogSink> default_log_sink;
+static bool binary_log = false;
+static int default_log_max_mb = 8;
+static int default_log_files = 4;
+static int default_status_hz = 2;
+static int default_capture_depth = 4;
 
 static void usage(const char *bin_name);
 static void init_log();
 static bool is_integer(const std::string &tested_integer);
+static bool parse_log_level(const std::string &level_string, base::log::Level &level);
 void signal_handler(int signum);
 
 static mavcam::MavClient client;
@@ -76,6 +87,43 @@ int main(int argc, const char *argv[]) {
             i++;
         } else if (current_arg == "--qgc") {
             compatible_qgc = true;
+        } else if (current_arg == "--log_level") {
+            if (argc <= i + 1) {
+                usage(argv[0]);
+                return 1;
+            }
+            base::log::Level log_level;
+            if (!parse_log_level(std::string(argv[i + 1]), log_level)) {
+                usage(argv[0]);
+                return 1;
+            }
+            base::log::set_min_level(log_level);
+            i++;
+        } else if (current_arg == "--log_max_mb" || current_arg == "--log_files" ||
+                   current_arg == "--status_hz" || current_arg == "--capture_depth") {
+            if (argc <= i + 1) {
+                usage(argv[0]);
+                return 1;
+            }
+            const std::string number_string(argv[i + 1]);
+            if (!is_integer(number_string) || number_string.empty()) {
+                usage(argv[0]);
+                return 1;
+            }
+            if (current_arg == "--log_max_mb") {
+                default_log_max_mb = std::stoi(number_string);
+            } else if (current_arg == "--log_files") {
+                default_log_files = std::max(std::stoi(number_string), 1);
+            } else if (current_arg == "--status_hz") {
+                default_status_hz = std::min(std::stoi(number_string), 20);
+            } else {
+                default_capture_depth = std::min(std::max(std::stoi(number_string), 1), 32);
+            }
+            i++;
+        } else if (current_arg == "--log_unlimited") {
+            base::log::get_rate_limiter().disable();
+        } else if (current_arg == "--log_binary") {
+            binary_log = true;
         } else if (current_arg == "--store_prefix") {
             if (argc <= i + 1) {
                 usage(argv[0]);
@@ -116,6 +164,9 @@ int main(int argc, const char *argv[]) {
 
     base::create_folder_if_not_exit(default_log_path);
     init_log();
+    base::StartupProfiler::instance().set_report("mav_client",
+                                                 default_log_path + "mav_client_startup.json");
+    base::Heartbeat::instance().open("mav_client");
     signal(SIGINT, signal_handler);
 
     base::LogDebug() << "Launch mav client";
@@ -132,15 +183,23 @@ int main(int argc, const char *argv[]) {
     }
 
     if (!client.init(connection_url, use_local, rpc_port, default_ftp_path, compatible_qgc,
-                     default_log_path)) {
+                     default_log_path, static_cast<size_t>(default_log_max_mb) * 1024 * 1024,
+                     default_log_files)) {
         std::cout << "Cannot init mav client " << connection_url << std::endl;
         return 1;
     }
 
-    client.start_runloop();
+    client.set_status_interval(std::chrono::milliseconds(
+        default_status_hz > 0 ? 1000 / default_status_hz : 0));
+    client.set_capture_depth(static_cast<size_t>(default_capture_depth));
+    // fails when connection or camera client cannot be created
+    bool result = client.start_runloop();
 
     base::LogDebug() << "Quit mav client";
-    return 0;
+    if (default_log_sink != nullptr) {
+        default_log_sink->close();
+    }
+    return result ? 0 : 1;
 }
 
 void usage(const char *bin_name) {
@@ -163,6 +222,17 @@ void usage(const char *bin_name) {
               << " (default is " << default_ftp_path << ")" << '\n'
               << "\t--log_path     : store output log to file path, default is " << default_log_path
               << '\n'
+              << "\t--log_level    : minimum log level, one of debug|info|warn|error" << '\n'
+              << "\t--log_binary   : store binary log, decode it with mav_log_decode" << '\n'
+              << "\t--log_unlimited: do not rate limit repeated log messages" << '\n'
+              << "\t--log_max_mb   : rotate log file at this size in MB, 0 disables rotation, "
+              << "default is " << default_log_max_mb << '\n'
+              << "\t--log_files    : log files kept for each log, default is " << default_log_files
+              << '\n'
+              << "\t--status_hz   : push changed camera status at this rate, 0 only answers "
+              << "polls, default is " << default_status_hz << '\n'
+              << "\t--capture_depth: photos taken ahead of their report before take photo is "
+              << "busy, default is " << default_capture_depth << '\n'
               << "\t--store_prefix : store folder and file prefix, default is "
               << default_store_prefix << '\n'
               << "\t--camera_mode  : init camera mode, 0 for photo mode 1 for video mode" << '\n'
@@ -175,45 +245,48 @@ static void init_log() {
     if (default_log_path.empty()) {
         return;
     }
-    std::string full_path = default_log_path + "mav_client.log";
-    auto log_stream =
-        std::make_shared<std::fstream>(full_path, std::fstream::out | std::fstream::binary);
-    if (!log_stream->is_open()) {
+    std::string full_path = default_log_path + (binary_log ? "mav_client.blog" : "mav_client.log");
+    auto log_sink = std::make_shared<base::AsyncLogSink>();
+    base::AsyncLogSink::Options options;
+    options.overflow_policy = base::AsyncLogSink::OverflowPolicy::Drop;
+    options.format =
+        binary_log ? base::AsyncLogSink::Format::Binary : base::AsyncLogSink::Format::Text;
+    options.max_file_size = static_cast<size_t>(default_log_max_mb) * 1024 * 1024;
+    options.max_files = default_log_files;
+    options.suppressed_interval = std::chrono::seconds(1);
+    if (!log_sink->open(full_path, options)) {
         base::LogError() << "Failed to open log file: " + full_path;
         return;
     }
-    base::log::subscribe([log_stream](base::log::Level level, const std::string &message,
-                                      const std::string &file, int line) -> bool {
-        std::stringstream ss;
-        time_t rawtime;
-        time(&rawtime);
-        struct tm *timeinfo = localtime(&rawtime);
-        char time_buffer[10]{};
-        strftime(time_buffer, sizeof(time_buffer), "%I:%M:%S", timeinfo);
-        ss << "[" << time_buffer;
-        switch (level) {
-            case base::log::Level::Debug:
-                ss << "|Debug] ";
-                break;
-            case base::log::Level::Info:
-                ss << "|Info ] ";
-                break;
-            case base::log::Level::Warn:
-                ss << "|Warn ] ";
-                break;
-            case base::log::Level::Err:
-                ss << "|Error] ";
-                break;
-        }
-        ss << " " << message << "\n";
-        if (log_stream->good()) {
-            log_stream->write(ss.str().c_str(), ss.str().size());
-            log_stream->flush();
-        }
+    default_log_sink = log_sink;
+    if (binary_log) {
+        base::log::subscribe_binary([log_sink](const char *data, size_t size) {
+            log_sink->push_record(data, size);
+        });
+        return;
+    }
+    base::log::subscribe([log_sink](base::log::Level level, const std::string &message,
+                                    const std::string &file, int line) -> bool {
+        log_sink->push(level, message);
         return false;
     });
 }
 
+bool parse_log_level(const std::string &level_string, base::log::Level &level) {
+    if (level_string == "debug") {
+        level = base::log::Level::Debug;
+    } else if (level_string == "info") {
+        level = base::log::Level::Info;
+    } else if (level_string == "warn") {
+        level = base::log::Level::Warn;
+    } else if (level_string == "error") {
+        level = base::log::Level::Err;
+    } else {
+        return false;
+    }
+    return true;
+}
+
 bool is_integer(const std::string &tested_integer) {
     for (const auto &digit : tested_integer) {
         if (!std::isdigit(digit)) {
@@ -223,7 +296,7 @@ bool is_integer(const std::string &tested_integer) {
     return true;
 }
 
-void signal_handler(int signum) {
-    base::LogDebug() << "Interrupt signal (" << signum << ") received.";
+void signal_handler(int /*signum*/) {
+    // only clears an atomic, the run loop logs and closes the sink on the main thread
     client.stop_runloop();
 }
\ No newline at end of file
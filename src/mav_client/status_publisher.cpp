@@ -0,0 +1,69 @@
+#include "status_publisher.h"
+
+#include <algorithm>
+
+#include "base/heartbeat.h"
+#include "base/log.h"
+
+namespace mavcam {
+
+StatusPublisher::StatusPublisher(std::chrono::milliseconds keepalive) : _keepalive(keepalive) {}
+
+StatusPublisher::~StatusPublisher() {
+    stop();
+}
+
+void StatusPublisher::add(PublishedTopic *topic) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _topics.push_back(topic);
+}
+
+void StatusPublisher::start(std::chrono::milliseconds interval) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_work_thread != nullptr || interval.count() <= 0) {
+        return;
+    }
+    base::LogInfo() << "Publish camera status every " << interval.count() << " ms";
+    _interval = interval;
+    _should_exit = false;
+    _work_thread = new std::thread(work_thread, this);
+}
+
+void StatusPublisher::stop() {
+    std::thread *thread = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _should_exit = true;
+        thread = _work_thread;
+        _work_thread = nullptr;
+    }
+    _cv.notify_one();
+    if (thread != nullptr) {
+        thread->join();
+        delete thread;
+    }
+}
+
+void StatusPublisher::work_thread(StatusPublisher *self) {
+    auto next = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(self->_mutex);
+    while (!self->_should_exit) {
+        next += self->_interval;
+        if (self->_cv.wait_until(lock, next, [self]() { return self->_should_exit; })) {
+            break;
+        }
+        lock.unlock();
+        {
+            base::HeartbeatScope heartbeat("status_publisher");
+            // topics are only added before start
+            for (auto *topic : self->_topics) {
+                topic->publish(self->_keepalive);
+            }
+        }
+        lock.lock();
+        // fall behind rather than publish in a burst
+        next = std::max(next, std::chrono::steady_clock::now() - self->_interval);
+    }
+}
+
+}  // namespace mavcam
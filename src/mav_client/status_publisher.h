@@ -0,0 +1,151 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mavcam {
+
+/**
+ * @brief State the ground station polls, see PublishedState
+ */
+class PublishedTopic {
+public:
+    virtual ~PublishedTopic() = default;
+    /**
+     * @brief sample the state, send it when it changed or keepalive passed since last send
+     */
+    virtual void publish(std::chrono::steady_clock::duration keepalive) = 0;
+};
+
+/**
+ * @brief Last sample of one state with the value sent last
+ * @details Polls are answered from the sample while it is younger than the poll window, so a
+ * ground station polling fast neither reads the camera nor gets a fresher answer than it needs.
+ * T needs operator==, which every MAVSDK struct has.
+ */
+template <typename T>
+class PublishedState final : public PublishedTopic {
+public:
+    using Sample = std::function<void(T &value)>;
+    using Send = std::function<void(const T &value)>;
+public:
+    PublishedState(Sample sample, Send send)
+        : _sample(std::move(sample)), _send(std::move(send)) {}
+public:
+    /**
+     * @brief answer a poll from the last sample
+     * @return false when there is none younger than max_age, the caller samples with respond()
+     */
+    bool respond_cached(std::chrono::steady_clock::duration max_age) {
+        T value;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (!_sampled || std::chrono::steady_clock::now() - _sample_time > max_age) {
+                return false;
+            }
+            value = _value;
+        }
+        _send(value);
+        return true;
+    }
+    /**
+     * @brief sample and send now
+     */
+    void respond() {
+        T value;
+        _sample(value);
+        store(value, true);
+        _send(value);
+    }
+    /**
+     * @brief drop the last sample after a command changed the state
+     */
+    void invalidate() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _sampled = false;
+    }
+    void publish(std::chrono::steady_clock::duration keepalive) override {
+        T value;
+        _sample(value);
+        if (store(value, false) || std::chrono::steady_clock::now() - send_time() >= keepalive) {
+            mark_sent(value);
+            _send(value);
+        }
+    }
+private:
+    /**
+     * @return value differs from the one sent last
+     */
+    bool store(const T &value, bool sent) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto now = std::chrono::steady_clock::now();
+        _value = value;
+        _sampled = true;
+        _sample_time = now;
+        bool changed = !_has_sent || !(_sent == value);
+        if (sent) {
+            _sent = value;
+            _has_sent = true;
+            _send_time = now;
+        }
+        return changed;
+    }
+    void mark_sent(const T &value) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _sent = value;
+        _has_sent = true;
+        _send_time = std::chrono::steady_clock::now();
+    }
+    std::chrono::steady_clock::time_point send_time() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _send_time;
+    }
+private:
+    Sample _sample;
+    Send _send;
+    std::mutex _mutex{};
+    T _value{};
+    bool _sampled{false};
+    std::chrono::steady_clock::time_point _sample_time{};
+    T _sent{};
+    bool _has_sent{false};
+    std::chrono::steady_clock::time_point _send_time{};
+};
+
+/**
+ * @brief Sends polled state on its own when it changed
+ * @details Every interval each topic is sampled and sent if it differs from what was sent last,
+ * unchanged state is sent again after keepalive, so a ground station that missed one message
+ * catches up without polling.
+ */
+class StatusPublisher final {
+public:
+    explicit StatusPublisher(std::chrono::milliseconds keepalive);
+    ~StatusPublisher();
+public:
+    /**
+     * @brief topic must outlive the publisher or stop(), add before start()
+     */
+    void add(PublishedTopic *topic);
+    /**
+     * @param interval 0 does not start, polls are still answered by the topics
+     */
+    void start(std::chrono::milliseconds interval);
+    void stop();
+private:
+    static void work_thread(StatusPublisher *self);
+private:
+    const std::chrono::milliseconds _keepalive;
+    std::chrono::milliseconds _interval{0};
+    std::vector<PublishedTopic *> _topics{};
+    std::mutex _mutex{};
+    std::condition_variable _cv{};
+    std::thread *_work_thread{nullptr};
+    bool _should_exit{false};
+};
+
+}  // namespace mavcam
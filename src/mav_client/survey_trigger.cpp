@@ -0,0 +1,134 @@
+#include "survey_trigger.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+#include "base/log.h"
+
+namespace mavcam {
+
+static constexpr double kEarthRadius = 6371000.0;
+static constexpr double kDegToRad = M_PI / 180.0;
+// a longer step between two positions is a jump of the estimate, not a flight
+static constexpr double kMaxStep = 500.0;
+static constexpr uint32_t kReportTriggers = 20;
+// upper bounds of the latency buckets in ms, the last bucket takes everything above
+static constexpr float kLatencyBounds[SurveyTrigger::kLatencyBuckets - 1] = {20,  50,  100,
+                                                                            200, 500, 1000};
+
+SurveyTrigger::SurveyTrigger(Fire fire) : _fire(std::move(fire)) {}
+
+void SurveyTrigger::set_distance(float distance_m) {
+    distance_m = std::isfinite(distance_m) ? std::max(distance_m, 0.0f) : 0.0f;
+    std::lock_guard<std::mutex> lock(_mutex);
+    float previous = _distance_m.exchange(distance_m);
+    if (previous == distance_m) {
+        return;
+    }
+    if (previous > 0.0f && _statistics.triggers > 0) {
+        log_statistics_locked();
+    }
+    if (distance_m > 0.0f) {
+        base::LogInfo() << "Start survey with a photo every " << distance_m << " m";
+        _statistics = Statistics{};
+        _latency_sum_ms = 0.0;
+    } else {
+        base::LogInfo() << "Stop survey";
+    }
+    _generation.fetch_add(1, std::memory_order_release);
+}
+
+void SurveyTrigger::on_position(const Position &position) {
+    float distance_m = _distance_m.load(std::memory_order_relaxed);
+    if (distance_m <= 0.0f) {
+        return;
+    }
+    auto time = std::chrono::steady_clock::now();
+    uint32_t generation = _generation.load(std::memory_order_acquire);
+    if (generation != _seen_generation) {
+        _seen_generation = generation;
+        _has_last = false;
+        _travelled_m = 0.0;
+        _sequence = 0;
+    }
+    if (!std::isfinite(position.latitude_deg) || !std::isfinite(position.longitude_deg) ||
+        (position.latitude_deg == 0.0 && position.longitude_deg == 0.0)) {
+        return;  // no fix
+    }
+    uint32_t missed = 0;
+    if (!_has_last) {
+        // first photo where the survey starts
+        _has_last = true;
+    } else {
+        double latitude = (position.latitude_deg + _last.latitude_deg) * 0.5 * kDegToRad;
+        double east = (position.longitude_deg - _last.longitude_deg) * kDegToRad *
+                      std::cos(latitude) * kEarthRadius;
+        double north = (position.latitude_deg - _last.latitude_deg) * kDegToRad * kEarthRadius;
+        double step = std::sqrt(east * east + north * north);
+        _last = position;
+        if (step > kMaxStep) {
+            base::LogWarn() << "Ignore position jump of " << step << " m in survey";
+            return;
+        }
+        _travelled_m += step;
+        double distance = static_cast<double>(distance_m);
+        if (_travelled_m < distance) {
+            return;
+        }
+        _travelled_m -= distance;
+        if (_travelled_m >= distance) {
+            missed = static_cast<uint32_t>(_travelled_m / distance);
+            _travelled_m = std::fmod(_travelled_m, distance);
+        }
+    }
+    _last = position;
+    bool accepted = _fire(_sequence++, position, time);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _statistics.triggers++;
+    _statistics.missed += missed;
+    if (!accepted) {
+        _statistics.refused++;
+    }
+}
+
+void SurveyTrigger::record_latency(std::chrono::steady_clock::duration latency) {
+    float latency_ms = std::chrono::duration<float, std::milli>(latency).count();
+    std::lock_guard<std::mutex> lock(_mutex);
+    size_t bucket = 0;
+    while (bucket < kLatencyBuckets - 1 && latency_ms >= kLatencyBounds[bucket]) {
+        bucket++;
+    }
+    _statistics.latency_buckets[bucket]++;
+    _statistics.latency_count++;
+    _latency_sum_ms += static_cast<double>(latency_ms);
+    _statistics.latency_mean_ms = static_cast<float>(_latency_sum_ms / _statistics.latency_count);
+    _statistics.latency_max_ms = std::max(_statistics.latency_max_ms, latency_ms);
+    if (_statistics.latency_count % kReportTriggers == 0) {
+        log_statistics_locked();
+    }
+}
+
+SurveyTrigger::Statistics SurveyTrigger::statistics() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _statistics;
+}
+
+void SurveyTrigger::log_statistics_locked() const {
+    std::ostringstream buckets;
+    for (size_t i = 0; i < kLatencyBuckets; i++) {
+        if (i < kLatencyBuckets - 1) {
+            buckets << " <" << kLatencyBounds[i] << "ms:";
+        } else {
+            buckets << " >=" << kLatencyBounds[i - 1] << "ms:";
+        }
+        buckets << _statistics.latency_buckets[i];
+    }
+    base::LogInfo() << "Survey " << _statistics.triggers << " triggers, " << _statistics.refused
+                    << " refused, " << _statistics.missed << " missed, latency mean "
+                    << _statistics.latency_mean_ms << " ms max " << _statistics.latency_max_ms
+                    << " ms," << buckets.str();
+}
+
+}  // namespace mavcam
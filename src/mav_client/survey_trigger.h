@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+
+namespace mavcam {
+
+/**
+ * @brief Fires a photo every time the vehicle covered a set ground distance
+ * @details on_position() runs in the telemetry callback for every GLOBAL_POSITION_INT, it only adds
+ * the flat earth distance to the last position and calls fire when the set distance is crossed,
+ * the distance beyond it counts towards the next photo so triggers do not drift. Latency from the
+ * position message to the photo is collected into a histogram and logged every kReportTriggers
+ * photos and when the survey is stopped.
+ */
+class SurveyTrigger final {
+public:
+    struct Position {
+        double latitude_deg{0.0};
+        double longitude_deg{0.0};
+        float absolute_altitude_m{0.0f};
+        float relative_altitude_m{0.0f};
+    };
+    /**
+     * @param sequence counts the photos of one survey from 0
+     * @param time arrival of the position message the trigger was computed at
+     * @return false when the capture path refused the photo
+     */
+    using Fire = std::function<bool(uint32_t sequence, const Position &position,
+                                    std::chrono::steady_clock::time_point time)>;
+    static constexpr size_t kLatencyBuckets = 7;
+    struct Statistics {
+        uint32_t triggers{0};
+        uint32_t refused{0};  ///< triggers the capture path did not accept
+        uint32_t missed{0};   ///< photos skipped as one position step covered several distances
+        uint32_t latency_count{0};
+        float latency_mean_ms{0.0f};
+        float latency_max_ms{0.0f};
+        uint32_t latency_buckets[kLatencyBuckets]{};  ///< see kLatencyBounds
+    };
+public:
+    explicit SurveyTrigger(Fire fire);
+public:
+    /**
+     * @brief start a survey with photos every distance_m, 0 stops it
+     */
+    void set_distance(float distance_m);
+    /**
+     * @brief feed one position, called from the telemetry callback
+     */
+    void on_position(const Position &position);
+    /**
+     * @brief latency of one survey photo, from its position message until it was taken
+     */
+    void record_latency(std::chrono::steady_clock::duration latency);
+    Statistics statistics() const;
+private:
+    void log_statistics_locked() const;
+private:
+    Fire _fire;
+    std::atomic<float> _distance_m{0.0f};
+    std::atomic<uint32_t> _generation{0};  ///< changes with every set_distance()
+    // used by the telemetry callback only
+    uint32_t _seen_generation{0};
+    bool _has_last{false};
+    Position _last{};
+    double _travelled_m{0.0};  ///< since the last photo
+    uint32_t _sequence{0};
+    mutable std::mutex _mutex{};  ///< guards the statistics
+    Statistics _statistics{};
+    double _latency_sum_ms{0.0};
+};
+
+}  // namespace mavcam
@@ -0,0 +1,294 @@
+#include <cstdint>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "base/log_binary.h"
+
+namespace binary = base::log::binary;
+
+struct Site {
+    uint8_t level{0};
+    uint32_t line{0};
+    std::string file{};
+    std::string format{};
+};
+
+using SiteMap = std::unordered_map<uint32_t, Site>;
+
+static void usage(const char *bin_name);
+static bool read_file(const std::string &path, std::string &content);
+static bool collect_sites(const std::string &path, const std::string &content, SiteMap &sites);
+static bool decode(const std::string &path, const std::string &content, const SiteMap &sites,
+                   bool show_source);
+
+int main(int argc, const char *argv[]) {
+    bool show_source = false;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; i++) {
+        const std::string current_arg = argv[i];
+        if (current_arg == "-h" || current_arg == "--help") {
+            usage(argv[0]);
+            return 0;
+        } else if (current_arg == "-s" || current_arg == "--source") {
+            show_source = true;
+        } else if (!current_arg.empty() && current_arg[0] == '-') {
+            usage(argv[0]);
+            return 1;
+        } else {
+            paths.push_back(current_arg);
+        }
+    }
+    if (paths.empty()) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    // every file starts with the site definitions known when it was opened, site ids are only
+    // valid inside one file since they differ between runs
+    bool complete = true;
+    for (const auto &path : paths) {
+        std::string content;
+        if (!read_file(path, content)) {
+            std::cerr << "Cannot read " << path << std::endl;
+            return 1;
+        }
+        SiteMap sites;
+        if (!collect_sites(path, content, sites)) {
+            return 1;
+        }
+        complete = decode(path, content, sites, show_source) && complete;
+    }
+    return complete ? 0 : 2;
+}
+
+void usage(const char *bin_name) {
+    std::cout << "Usage: " << bin_name << " [Options] <binary log file>..." << '\n'
+              << '\n'
+              << "Decode binary log of mav_client and mav_server to text, give rotated files "
+              << "from oldest to newest, e.g. mav_client.blog.1 mav_client.blog" << '\n'
+              << '\n'
+              << "Options:" << '\n'
+              << "\t-h | --help   : show this help" << '\n'
+              << "\t-s | --source : append source file and line of each message" << '\n';
+}
+
+static bool read_file(const std::string &path, std::string &content) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::stringstream ss;
+    ss << file.rdbuf();
+    content = ss.str();
+    return true;
+}
+
+/**
+ * @brief call handler for every complete record
+ * @return false when file is not a binary log, a truncated tail record is skipped
+ */
+template <typename Handler>
+static bool for_each_record(const std::string &path, const std::string &content,
+                            Handler &&handler) {
+    if (content.compare(0, binary::kFileMagicSize, binary::kFileMagic) != 0) {
+        std::cerr << path << " is not a binary log file" << std::endl;
+        return false;
+    }
+    const char *data = content.data() + binary::kFileMagicSize;
+    const char *end = content.data() + content.size();
+    while (data < end) {
+        uint8_t type = 0;
+        uint16_t size = 0;
+        if (!binary::get(data, end, type) || !binary::get(data, end, size) ||
+            end - data < size) {
+            std::cerr << path << " ends with a truncated record" << std::endl;
+            break;
+        }
+        handler(static_cast<binary::RecordType>(type), data, data + size);
+        data += size;
+    }
+    return true;
+}
+
+static bool collect_sites(const std::string &path, const std::string &content, SiteMap &sites) {
+    return for_each_record(path, content,
+                           [&sites](binary::RecordType type, const char *data, const char *end) {
+                               if (type != binary::RecordType::SiteDefinition) {
+                                   return;
+                               }
+                               uint32_t id = 0;
+                               Site site;
+                               std::string_view file;
+                               std::string_view format;
+                               if (binary::get(data, end, id) &&
+                                   binary::get(data, end, site.level) &&
+                                   binary::get(data, end, site.line) &&
+                                   binary::get_string(data, end, file) &&
+                                   binary::get_string(data, end, format)) {
+                                   site.file = file;
+                                   site.format = format;
+                                   sites[id] = site;
+                               }
+                           });
+}
+
+static const char *level_tag(uint8_t level) {
+    switch (level) {
+        case 0:
+            return "Debug";
+        case 1:
+            return "Info ";
+        case 2:
+            return "Warn ";
+        case 3:
+            return "Error";
+    }
+    return "?????";
+}
+
+static std::string format_time(uint64_t time_us) {
+    time_t seconds = static_cast<time_t>(time_us / 1000000);
+    struct tm local_time;
+    localtime_r(&seconds, &local_time);
+    char time_buffer[16]{};
+    strftime(time_buffer, sizeof(time_buffer), "%I:%M:%S", &local_time);
+    char result[32]{};
+    snprintf(result, sizeof(result), "%s.%03u", time_buffer,
+             static_cast<unsigned>(time_us / 1000 % 1000));
+    return result;
+}
+
+/**
+ * @brief print next argument as operator<< of text log does
+ */
+static bool format_arg(const char *&data, const char *end, std::ostream &out) {
+    uint8_t type = 0;
+    if (!binary::get(data, end, type)) {
+        return false;
+    }
+    switch (static_cast<binary::ArgType>(type)) {
+        case binary::ArgType::Int: {
+            int64_t value = 0;
+            if (!binary::get_zigzag(data, end, value)) {
+                return false;
+            }
+            out << value;
+            return true;
+        }
+        case binary::ArgType::UInt: {
+            uint64_t value = 0;
+            if (!binary::get_varint(data, end, value)) {
+                return false;
+            }
+            out << value;
+            return true;
+        }
+        case binary::ArgType::Double: {
+            double value = 0;
+            if (!binary::get(data, end, value)) {
+                return false;
+            }
+            out << value;
+            return true;
+        }
+        case binary::ArgType::Bool: {
+            uint8_t value = 0;
+            if (!binary::get(data, end, value)) {
+                return false;
+            }
+            out << (value != 0);
+            return true;
+        }
+        case binary::ArgType::Char: {
+            char value = 0;
+            if (!binary::get(data, end, value)) {
+                return false;
+            }
+            out << value;
+            return true;
+        }
+        case binary::ArgType::String: {
+            std::string_view value;
+            if (!binary::get_string(data, end, value)) {
+                return false;
+            }
+            out << value;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void format_message(const Site &site, const char *data, const char *end,
+                           std::ostream &out) {
+    const std::string &format = site.format;
+    for (size_t i = 0; i < format.size(); i++) {
+        char c = format[i];
+        if ((c == '{' || c == '}') && i + 1 < format.size() && format[i + 1] == c) {
+            out << c;
+            i++;
+        } else if (c == '{' && i + 1 < format.size() && format[i + 1] == '}') {
+            if (!format_arg(data, end, out)) {
+                out << "<?>";
+            }
+            i++;
+        } else {
+            out << c;
+        }
+    }
+}
+
+static bool decode(const std::string &path, const std::string &content, const SiteMap &sites,
+                   bool show_source) {
+    size_t unknown_count = 0;
+    bool valid = for_each_record(
+        path, content,
+        [&sites, &unknown_count, show_source](binary::RecordType type, const char *data,
+                                              const char *end) {
+            uint64_t time_us = 0;
+            if (type == binary::RecordType::Dropped) {
+                uint64_t count = 0;
+                if (binary::get(data, end, time_us) && binary::get(data, end, count)) {
+                    std::cout << "[" << format_time(time_us) << "|Warn ]  " << count
+                              << " log messages dropped" << '\n';
+                }
+                return;
+            }
+            if (type != binary::RecordType::Message && type != binary::RecordType::Repeated) {
+                return;
+            }
+            uint32_t id = 0;
+            if (!binary::get(data, end, id) || !binary::get(data, end, time_us)) {
+                return;
+            }
+            auto site = sites.find(id);
+            if (site == sites.end()) {
+                unknown_count++;
+                return;
+            }
+            std::cout << "[" << format_time(time_us) << "|" << level_tag(site->second.level)
+                      << "]  ";
+            uint32_t repeated = 0;
+            if (type == binary::RecordType::Message) {
+                format_message(site->second, data, end, std::cout);
+            } else if (binary::get(data, end, repeated)) {
+                std::cout << repeated << " messages suppressed at " << site->second.file << ":"
+                          << site->second.line;
+            }
+            if (show_source && type == binary::RecordType::Message) {
+                std::cout << " (" << site->second.file << ":" << site->second.line << ")";
+            }
+            std::cout << '\n';
+        });
+    if (unknown_count > 0) {
+        std::cerr << path << " has " << unknown_count << " messages without site definition"
+                  << std::endl;
+    }
+    return valid && unknown_count == 0;
+}
@@ -5,6 +5,7 @@
 #include <thread>
 
 #include "base/log.h"
+#include "base/startup_profiler.h"
 #include "plugins/camera/camera_impl.h"
 #include "plugins/camera/camera_service_impl.h"
 
@@ -36,11 +37,21 @@ bool MavServer::start_runloop() {
                                     _num_thread);
     }
 
-    _server = builder.BuildAndStart();
-    if (!_server) {
+    base::StartupPhase phase("grpc_server_start");
+    auto server = builder.BuildAndStart();
+    phase.stop();
+    if (!server) {
         base::LogError() << "Failed to start server on " << server_address;
         return false;
     }
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _server = std::move(server);
+        // stopped while the server was built
+        if (_stopped) {
+            _server->Shutdown();
+        }
+    }
 
     // Run server
     base::LogInfo() << "Server listening on " << server_address;
@@ -49,7 +60,11 @@ bool MavServer::start_runloop() {
 }
 
 void MavServer::stop_runloop() {
-    _server->Shutdown();
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stopped = true;
+    if (_server) {
+        _server->Shutdown();
+    }
 }
 
 }  // namespace mavcam
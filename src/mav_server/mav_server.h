@@ -2,6 +2,8 @@
 
 #include <grpc++/grpc++.h>
 
+#include <mutex>
+
 namespace mavcam {
 
 class MavServer final {
@@ -11,11 +13,16 @@ public:
 public:
     bool init(int rpc_port, int num_thread);
     bool start_runloop();
+    /**
+     * @brief can be called from another thread at any time, also before the server is built
+     */
     void stop_runloop();
 private:
     int _rpc_port;
     int _num_thread{0};
+    std::mutex _mutex{};  ///< guards _server and _stopped
     std::unique_ptr<grpc::Server> _server;
+    bool _stopped{false};
 };
 
 }  // namespace mavcam
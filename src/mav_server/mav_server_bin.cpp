@@ -1,22 +1,38 @@
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
 #include <csignal>
-#include <fstream>
 #include <iostream>
 #include <regex>
+#include <thread>
 
 #include "base/file_operation.h"
+#include "base/heartbeat.h"
 #include "base/log.h"
+#include "base/log_rate_limiter.h"
+#include "base/log_sink.h"
+#include "base/startup_profiler.h"
 #include "mav_server.h"
 #include "version.h"
 
 static auto constexpr default_rpc_port = 50051;
 static std::string default_log_path = "/data/camera/";
-static std::fstream *default_log_stream = nullptr;
+static std::shared_ptr<base::AsyncLogSink> default_log_sink;
+static bool binary_log = false;
+static int default_log_max_mb = 8;
+static int default_log_files = 4;
 static std::string default_store_prefix = "NDAA";
+// written by the signal handler, read by the stop thread
+static int stop_pipe[2] = {-1, -1};
 
 static void usage(const char *bin_name);
 static void init_log();
 static bool is_integer(const std::string &tested_integer);
+static bool parse_log_level(const std::string &level_string, base::log::Level &level);
 void signal_handler(int signum);
+static void stop_thread();
 
 mavcam::MavServer server;
 
@@ -66,6 +82,38 @@ int main(int argc, const char *argv[]) {
             }
             default_log_path = std::string(argv[i + 1]);
             i++;
+        } else if (current_arg == "--log_level") {
+            if (argc <= i + 1) {
+                usage(argv[0]);
+                return 1;
+            }
+            base::log::Level log_level;
+            if (!parse_log_level(std::string(argv[i + 1]), log_level)) {
+                usage(argv[0]);
+                return 1;
+            }
+            base::log::set_min_level(log_level);
+            i++;
+        } else if (current_arg == "--log_max_mb" || current_arg == "--log_files") {
+            if (argc <= i + 1) {
+                usage(argv[0]);
+                return 1;
+            }
+            const std::string number_string(argv[i + 1]);
+            if (!is_integer(number_string) || number_string.empty()) {
+                usage(argv[0]);
+                return 1;
+            }
+            if (current_arg == "--log_max_mb") {
+                default_log_max_mb = std::stoi(number_string);
+            } else {
+                default_log_files = std::max(std::stoi(number_string), 1);
+            }
+            i++;
+        } else if (current_arg == "--log_unlimited") {
+            base::log::get_rate_limiter().disable();
+        } else if (current_arg == "--log_binary") {
+            binary_log = true;
         } else if (current_arg == "--store_prefix") {
             if (argc <= i + 1) {
                 usage(argv[0]);
@@ -105,6 +153,14 @@ int main(int argc, const char *argv[]) {
 
     base::create_folder_if_not_exit(default_log_path);
     init_log();
+    base::StartupProfiler::instance().set_report("mav_server",
+                                                 default_log_path + "mav_server_startup.json");
+    base::Heartbeat::instance().open("mav_server");
+    if (pipe2(stop_pipe, O_CLOEXEC) != 0) {
+        std::cout << "Cannot create stop pipe";
+        return 1;
+    }
+    std::thread stop_watcher(stop_thread);
     signal(SIGINT, signal_handler);
     base::LogDebug() << "Launch mav server";
     setenv("MAVCAM_DEFAULT_STORE_PREFIX", default_store_prefix.c_str(), 1);
@@ -118,19 +174,21 @@ int main(int argc, const char *argv[]) {
         base::LogInfo() << "Init camera snapshot resolution is " << init_snapshot_resolution;
     }
 
-    if (!server.init(rpc_port, num_thread)) {
+    bool result = server.init(rpc_port, num_thread) && server.start_runloop();
+    if (!result) {
         std::cout << "Init rpc server failed";
-        return 1;
     }
-
-    server.start_runloop();
+    // wake the stop thread when the server quit on its own
+    const char quit = 0;
+    if (write(stop_pipe[1], &quit, 1) != 1) {
+        base::LogError() << "Cannot wake stop thread";
+    }
+    stop_watcher.join();
     base::LogDebug() << "Quit mav server";
-    if (default_log_stream != nullptr) {
-        default_log_stream->close();
-        delete default_log_stream;
-        default_log_stream = nullptr;
+    if (default_log_sink != nullptr) {
+        default_log_sink->close();
     }
-    return 0;
+    return result ? 0 : 1;
 }
 
 void usage(const char *bin_name) {
@@ -144,6 +202,14 @@ void usage(const char *bin_name) {
               << "\t-t | --num_thread   : set the rpc thread count" << '\n'
               << "\t--log_path          : store output log to file path, default is "
               << default_log_path << '\n'
+              << "\t--log_level         : minimum log level, one of debug|info|warn|error"
+              << '\n'
+              << "\t--log_binary        : store binary log, decode it with mav_log_decode"
+              << '\n'
+              << "\t--log_unlimited     : do not rate limit repeated log messages" << '\n'
+              << "\t--log_max_mb        : rotate log file at this size in MB, 0 disables "
+              << "rotation, default is " << default_log_max_mb << '\n'
+              << "\t--log_files         : log files kept, default is " << default_log_files << '\n'
               << "\t--store_prefix      : store folder and file prefix, default is "
               << default_store_prefix << '\n'
               << "\t--camera_mode       : init camera mode, 0 for photo mode 1 for video mode"
@@ -152,44 +218,49 @@ void usage(const char *bin_name) {
 }
 
 static void init_log() {
-    if (!default_log_path.empty()) {
-        std::string full_path = default_log_path + "mav_server.log";
-        default_log_stream = new std::fstream(full_path, std::fstream::out | std::fstream::binary);
-        if (!default_log_stream->is_open()) {
-            base::LogError() << "Failed to open log file: " + full_path;
-        }
-        base::log::subscribe([](base::log::Level level, const std::string &message,
-                                const std::string &file, int line) -> bool {
-            std::stringstream ss;
-            time_t rawtime;
-            time(&rawtime);
-            struct tm *timeinfo = localtime(&rawtime);
-            char time_buffer[10]{};
-            strftime(time_buffer, sizeof(time_buffer), "%I:%M:%S", timeinfo);
-            ss << "[" << time_buffer;
-
-            switch (level) {
-                case base::log::Level::Debug:
-                    ss << "|Debug] ";
-                    break;
-                case base::log::Level::Info:
-                    ss << "|Info ] ";
-                    break;
-                case base::log::Level::Warn:
-                    ss << "|Warn ] ";
-                    break;
-                case base::log::Level::Err:
-                    ss << "|Error] ";
-                    break;
-            }
-            ss << " " << message << "\n";
-            if (default_log_stream->good()) {
-                default_log_stream->write(ss.str().c_str(), ss.str().size());
-                default_log_stream->flush();
-            }
-            return false;
+    if (default_log_path.empty()) {
+        return;
+    }
+    std::string full_path = default_log_path + (binary_log ? "mav_server.blog" : "mav_server.log");
+    auto log_sink = std::make_shared<base::AsyncLogSink>();
+    base::AsyncLogSink::Options options;
+    options.overflow_policy = base::AsyncLogSink::OverflowPolicy::Drop;
+    options.format =
+        binary_log ? base::AsyncLogSink::Format::Binary : base::AsyncLogSink::Format::Text;
+    options.max_file_size = static_cast<size_t>(default_log_max_mb) * 1024 * 1024;
+    options.max_files = default_log_files;
+    options.suppressed_interval = std::chrono::seconds(1);
+    if (!log_sink->open(full_path, options)) {
+        base::LogError() << "Failed to open log file: " + full_path;
+        return;
+    }
+    default_log_sink = log_sink;
+    if (binary_log) {
+        base::log::subscribe_binary([log_sink](const char *data, size_t size) {
+            log_sink->push_record(data, size);
         });
+        return;
     }
+    base::log::subscribe([log_sink](base::log::Level level, const std::string &message,
+                                    const std::string &file, int line) -> bool {
+        log_sink->push(level, message);
+        return false;
+    });
+}
+
+bool parse_log_level(const std::string &level_string, base::log::Level &level) {
+    if (level_string == "debug") {
+        level = base::log::Level::Debug;
+    } else if (level_string == "info") {
+        level = base::log::Level::Info;
+    } else if (level_string == "warn") {
+        level = base::log::Level::Warn;
+    } else if (level_string == "error") {
+        level = base::log::Level::Err;
+    } else {
+        return false;
+    }
+    return true;
 }
 
 bool is_integer(const std::string &tested_integer) {
@@ -202,8 +273,20 @@ bool is_integer(const std::string &tested_integer) {
 }
 
 void signal_handler(int signum) {
-    base::LogDebug() << "Interrupt signal (" << signum << ") received.";
-    server.stop_runloop();
+    // only async signal safe calls, logging or stopping here can deadlock on the interrupted thread
+    const char signal_number = static_cast<char>(signum);
+    if (write(stop_pipe[1], &signal_number, 1) != 1) {
+        _exit(signum);
+    }
+}
 
-    exit(signum);  // Exit the process
+static void stop_thread() {
+    char signum = 0;
+    while (read(stop_pipe[0], &signum, 1) < 0 && errno == EINTR) {
+    }
+    if (signum == 0) {
+        return;
+    }
+    base::LogDebug() << "Interrupt signal (" << static_cast<int>(signum) << ") received.";
+    server.stop_runloop();
 }
\ No newline at end of file
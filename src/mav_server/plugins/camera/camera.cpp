@@ -362,7 +362,16 @@ bool operator==(const Camera::Status &lhs, const Camera::Status &rhs) {
             rhs.recording_time_s == lhs.recording_time_s) &&
            (rhs.media_folder_name == lhs.media_folder_name) &&
            (rhs.storage_status == lhs.storage_status) && (rhs.storage_id == lhs.storage_id) &&
-           (rhs.storage_type == lhs.storage_type);
+           (rhs.storage_type == lhs.storage_type) &&
+           (rhs.photo_interval_triggers == lhs.photo_interval_triggers) &&
+           (rhs.photo_interval_failed == lhs.photo_interval_failed) &&
+           (rhs.photo_interval_missed == lhs.photo_interval_missed) &&
+           ((std::isnan(rhs.photo_interval_mean_jitter_ms) &&
+             std::isnan(lhs.photo_interval_mean_jitter_ms)) ||
+            rhs.photo_interval_mean_jitter_ms == lhs.photo_interval_mean_jitter_ms) &&
+           ((std::isnan(rhs.photo_interval_max_jitter_ms) &&
+             std::isnan(lhs.photo_interval_max_jitter_ms)) ||
+            rhs.photo_interval_max_jitter_ms == lhs.photo_interval_max_jitter_ms);
 }
 
 std::ostream &operator<<(std::ostream &str, Camera::Status const &status) {
@@ -378,6 +387,11 @@ std::ostream &operator<<(std::ostream &str, Camera::Status const &status) {
     str << "    storage_status: " << status.storage_status << '\n';
     str << "    storage_id: " << status.storage_id << '\n';
     str << "    storage_type: " << status.storage_type << '\n';
+    str << "    photo_interval_triggers: " << status.photo_interval_triggers << '\n';
+    str << "    photo_interval_failed: " << status.photo_interval_failed << '\n';
+    str << "    photo_interval_missed: " << status.photo_interval_missed << '\n';
+    str << "    photo_interval_mean_jitter_ms: " << status.photo_interval_mean_jitter_ms << '\n';
+    str << "    photo_interval_max_jitter_ms: " << status.photo_interval_max_jitter_ms << '\n';
     str << '}';
     return str;
 }
@@ -352,6 +352,16 @@ public:
         StorageStatus storage_status{};  /**< @brief Storage status */
         uint32_t storage_id{};           /**< @brief Storage ID starting at 1 */
         StorageType storage_type{};      /**< @brief Storage type */
+        uint32_t
+            photo_interval_triggers{}; /**< @brief Photos taken by the current or last photo interval */
+        uint32_t
+            photo_interval_failed{}; /**< @brief Photos of the current or last photo interval that failed */
+        uint32_t
+            photo_interval_missed{}; /**< @brief Interval deadlines skipped while a photo was in progress */
+        float
+            photo_interval_mean_jitter_ms{}; /**< @brief Mean delay of interval photos behind their deadline (in ms) */
+        float
+            photo_interval_max_jitter_ms{}; /**< @brief Max delay of interval photos behind their deadline (in ms) */
     };
 
     /**
@@ -1,7 +1,9 @@
 #include "camera_impl.h"
 
 #include <dlfcn.h>
+#include <link.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #include <iomanip>  // for std::setprecision
@@ -9,23 +11,24 @@
 #include <thread>
 
 #include "base/log.h"
+#include "base/startup_profiler.h"
+#include "camera_settings.h"
 
 namespace mavcam {
 
-const std::string kCameraModeName = "CAM_MODE";
-const std::string kCameraDisplayModeName = "CAM_DIS_MODE";
-const std::string kPhotoResolution = "CAM_PHOTO_RES";
-const std::string kVideoResolution = "CAM_VIDRES";
-const std::string kVideoFormat = "CAM_VIDFMT";
-const std::string kWhitebalanceModeName = "CAM_WBMODE";
-const std::string kExposureMode = "CAM_EXPMODE";
-const std::string kEVName = "CAM_EV";
-const std::string kISOName = "CAM_ISO";
-const std::string kShutterSpeedName = "CAM_SHUTTERSPD";
-const std::string kMeteringModeName = "CAM_METER";
-
-const std::string kIrCamPalette = "IRCAM_PALETTE";
-const std::string kIrCamFFC = "IRCAM_FFC";
+using settings::SettingId;
+
+static const char *kModelName = settings::kModelName;
+static const char *kFirmwareVersion = "0.7.0";
+// setting values read from hardware on last start, lets prepare() skip the getters
+static const char *kSettingsSnapshotPath = "/data/camera/mav_server_settings.snapshot";
+static const std::string kSnapshotWidthKey = "SNAPSHOT_WIDTH";
+static const std::string kSnapshotHeightKey = "SNAPSHOT_HEIGHT";
+// settings read by read_hardware_settings() besides the ir palette
+static constexpr SettingId kHardwareSettings[] = {SettingId::CamDisMode, SettingId::CamWbmode,
+                                                  SettingId::CamEv,      SettingId::CamIso,
+                                                  SettingId::CamShutterspd,
+                                                  SettingId::CamVidres};
 
 static const int32_t kPreviewWidth = 1920;
 static const int32_t kPreviewPhotoHeight = 1440;
@@ -58,13 +61,16 @@ Camera::Result CameraImpl::prepare() {
     }
 
     //init ir camera first for ir stream function
+    base::StartupPhase ir_phase("ir_camera");
     auto ir_result = init_ir_camera();
-    if (ir_result) {
-        int color_mode = get_ir_palette();
-        _settings.emplace_back(build_setting(kIrCamPalette, std::to_string(color_mode)));
-        _settings.emplace_back(build_setting(kIrCamFFC, "0"));
-    }
+    ir_phase.stop();
 
+    base::StartupPhase snapshot_phase("settings_snapshot_load");
+    SettingsSnapshot snapshot;
+    bool warm_start = snapshot.load(kSettingsSnapshotPath);
+    snapshot_phase.stop();
+
+    base::StartupPhase dlopen_phase("qcom_dlopen");
     _plugin_handle = dlopen(QCOM_CAMERA_LIBERAY, RTLD_NOW);
     if (_plugin_handle == NULL) {
         char const *err_str = dlerror();
@@ -90,13 +96,43 @@ Camera::Result CameraImpl::prepare() {
         return Camera::Result::Error;
     }
 
+    dlopen_phase.stop();
+
     _mav_camera->set_log_path("/data/camera/qcom_cam.log");
+    base::StartupPhase prepare_phase("qcom_prepare");
     mav_camera::Result result = _mav_camera->prepare();
+    prepare_phase.stop();
     if (result != mav_camera::Result::Success) {
         base::LogDebug() << "cannot find qcom camera";
         return Camera::Result::Error;
     }
 
+    // a snapshot of the same model and firmware holds every value the getters would return
+    read_rgb_version();
+    if (warm_start && _rgb_version.empty()) {
+        warm_start = false;
+    } else if (warm_start && snapshot.identity != settings_identity()) {
+        base::LogInfo() << "Settings snapshot of " << snapshot.identity << " does not match "
+                        << settings_identity();
+        warm_start = false;
+    }
+    settings::SettingValues hardware_values;
+    for (auto id : kHardwareSettings) {
+        warm_start = warm_start && snapshot.values.count(settings::setting_name(id)) > 0;
+    }
+    if (ir_result) {
+        warm_start =
+            warm_start && snapshot.values.count(settings::setting_name(SettingId::IrcamPalette)) > 0;
+    }
+    if (warm_start) {
+        for (const auto &[key, value] : snapshot.values) {
+            SettingId id;
+            if (settings::find_setting(key, id)) {
+                hardware_values[id] = value;
+            }
+        }
+    }
+
     mav_camera::Options options;
     options.preview_drm_output = false;
     options.preview_v4l2_output = false;
@@ -131,22 +167,24 @@ Camera::Result CameraImpl::prepare() {
             // for manually set snapshot resolution, not use half snapshot resolution
             options.snapshot_width = kSnapshotWidth;
             options.snapshot_height = kSnapshotHeight;
-            _settings.emplace_back(build_setting(kPhotoResolution, "0"));
+            _settings[SettingId::CamPhotoRes] = "0";
         }
     } else {
-        int32_t snapshot_width = 0;
-        int32_t snpashot_height = 0;
-        std::tie(result, kSnapshotWidth, kSnapshotHeight) = _mav_camera->get_snapshot_resolution();
+        if (!warm_start || !snapshot.get_int(kSnapshotWidthKey, kSnapshotWidth) ||
+            !snapshot.get_int(kSnapshotHeightKey, kSnapshotHeight)) {
+            std::tie(result, kSnapshotWidth, kSnapshotHeight) =
+                _mav_camera->get_snapshot_resolution();
+        }
         kSnapshotHalfWidth = kSnapshotWidth / 2;
         kSnapshotHalfHeight = kSnapshotHeight / 2;
         if (kSnapshotWidth > 8000) {  // for 64M mode, use half width and height
             options.snapshot_width = kSnapshotHalfWidth;
             options.snapshot_height = kSnapshotHalfHeight;
-            _settings.emplace_back(build_setting(kPhotoResolution, "1"));  // 1 for 1/4 resolution
+            _settings[SettingId::CamPhotoRes] = "1";  // 1 for 1/4 resolution
         } else {
             options.snapshot_width = kSnapshotWidth;
             options.snapshot_height = kSnapshotHeight;
-            _settings.emplace_back(build_setting(kPhotoResolution, "0"));
+            _settings[SettingId::CamPhotoRes] = "0";
         }
     }
 
@@ -172,15 +210,17 @@ Camera::Result CameraImpl::prepare() {
         base::LogInfo() << "Set store prefix to " << options.store_prefix;
     }
 
+    base::StartupPhase open_phase("qcom_open");
     result = _mav_camera->open(options);
+    open_phase.stop();
     if (result == mav_camera::Result::Success) {
         base::LogDebug() << "open qcom camera success";
     }
 
     if (options.init_mode == mav_camera::Mode::Photo) {
-        _settings.emplace_back(build_setting(kCameraModeName, "0"));
+        _settings[SettingId::CamMode] = "0";
     } else {
-        _settings.emplace_back(build_setting(kCameraModeName, "1"));
+        _settings[SettingId::CamMode] = "1";
     }
 
     _mav_camera->subscribe_storage_information(
@@ -190,27 +230,36 @@ Camera::Result CameraImpl::prepare() {
         });
 
     // init all settings
-    auto display_mode = get_camera_display_mode();
-    _settings.emplace_back(build_setting(kCameraDisplayModeName, display_mode));
-    std::string wb_mode = get_whitebalance_mode();
-    _settings.emplace_back(build_setting(kWhitebalanceModeName, wb_mode));
+    base::StartupPhase settings_phase("settings_init");
+    if (!warm_start) {
+        read_hardware_settings(hardware_values);
+    }
+    for (auto id : kHardwareSettings) {
+        _settings[id] = hardware_values[id];
+    }
+    if (ir_result) {
+        _settings[SettingId::IrcamPalette] = hardware_values[SettingId::IrcamPalette];
+        _settings[SettingId::IrcamFfc] = "0";
+    }
     // 0 for auto exposure mode
-    _settings.emplace_back(build_setting(kExposureMode, "0"));
-    std::string ev_value = get_ev_value();
-    _settings.emplace_back(build_setting(kEVName, ev_value));
-    std::string iso_value = get_iso_value();
-    _settings.emplace_back(build_setting(kISOName, iso_value));
-    std::string shutter_speed_value = get_shutter_speed_value();
-    _settings.emplace_back(build_setting(kShutterSpeedName, shutter_speed_value));
-    _settings.emplace_back(build_setting(kVideoFormat, "1"));
-    std::string video_resolution = get_video_resolution();
-    _settings.emplace_back(build_setting(kVideoResolution, video_resolution));
-    _settings.emplace_back(build_setting(kMeteringModeName, "0"));
-
-    base::LogDebug() << "Init settings :";
-    for (const auto &setting : _settings) {
-        base::LogDebug() << "  - " << setting.setting_id << " : " << setting.option.option_id;
+    _settings[SettingId::CamExpmode] = "0";
+    _settings[SettingId::CamVidfmt] = "1";
+    _settings[SettingId::CamMeter] = "0";
+
+    {
+        base::log::RateLimitExemptScope exempt;
+        base::LogDebug() << "Init settings" << (warm_start ? " from snapshot" : "") << " :";
+        for (const auto &setting : current_settings()) {
+            base::LogDebug() << "  - " << setting.setting_id << " : " << setting.option.option_id;
+        }
+    }
+    if (warm_start) {
+        _verify_thread = new std::thread(verify_settings_thread, this);
+    } else {
+        save_settings_snapshot(hardware_values);
     }
+    settings_phase.stop();
+    base::StartupProfiler::instance().finish();
     return Camera::Result::Success;
 }
 
@@ -222,12 +271,29 @@ Camera::Result CameraImpl::take_photo() {
 
 Camera::Result CameraImpl::start_photo_interval(float interval_s) {
     base::LogDebug() << "call start photo interval " << interval_s;
-    return Camera::Result::ProtocolUnsupported;
+    if (!(interval_s > 0.0f)) {
+        return Camera::Result::WrongArgument;
+    }
+    if (_interval_scheduler.running()) {
+        return Camera::Result::Busy;
+    }
+    auto interval = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::duration<float>(interval_s));
+    if (!_interval_scheduler.start(interval, 0,
+                                   [this]() { return take_photo() == Camera::Result::Success; })) {
+        return Camera::Result::Error;
+    }
+    return Camera::Result::Success;
 }
 
 Camera::Result CameraImpl::stop_photo_interval() {
     base::LogDebug() << "call stop photo interval";
-    return Camera::Result::ProtocolUnsupported;
+    _interval_scheduler.stop();
+    auto statistics = _interval_scheduler.statistics();
+    base::LogInfo() << "Photo interval took " << statistics.triggers << " photos, failed "
+                    << statistics.failed << ", missed " << statistics.missed << ", jitter mean "
+                    << statistics.mean_jitter_ms << " ms max " << statistics.max_jitter_ms << " ms";
+    return Camera::Result::Success;
 }
 
 Camera::Result CameraImpl::start_video() {
@@ -276,7 +342,7 @@ Camera::Result CameraImpl::set_mode(Camera::Mode mode) {
     } else {
         setting_mode = "1";
     }
-    auto setting = build_setting(kCameraModeName, setting_mode);
+    auto setting = build_setting(SettingId::CamMode, setting_mode);
     // use set setting to change camera mode
     return set_setting(setting);
 }
@@ -314,8 +380,8 @@ Camera::Information CameraImpl::information() const {
     }
     if (result == mav_camera::Result::Success) {
         out_info.vendor_name = "Aeroratech";
-        out_info.model_name = "D64TR";
-        out_info.firmware_version = "0.7.0";
+        out_info.model_name = kModelName;
+        out_info.firmware_version = kFirmwareVersion;
         out_info.focal_length_mm = in_info.focal_length_mm;
         out_info.horizontal_sensor_size_mm = in_info.horizontal_sensor_size_mm;
         out_info.vertical_sensor_size_mm = in_info.vertical_sensor_size_mm;
@@ -433,6 +499,13 @@ Camera::Status CameraImpl::status() const {
             _status.storage_type = Camera::Status::StorageType::UsbStick;
             break;
     }
+    _status.photo_interval_on = _interval_scheduler.running();
+    auto statistics = _interval_scheduler.statistics();
+    _status.photo_interval_triggers = statistics.triggers;
+    _status.photo_interval_failed = statistics.failed;
+    _status.photo_interval_missed = statistics.missed;
+    _status.photo_interval_mean_jitter_ms = statistics.mean_jitter_ms;
+    _status.photo_interval_max_jitter_ms = statistics.max_jitter_ms;
     if (_status.video_on) {
         auto current_time = std::chrono::steady_clock::now();
         _status.recording_time_s =
@@ -446,81 +519,128 @@ Camera::Status CameraImpl::status() const {
 
 void CameraImpl::current_settings_async(const Camera::CurrentSettingsCallback &callback) {
     base::LogDebug() << "call current_settings_async";
-    callback(_settings);
+    callback(current_settings());
 }
 
 std::vector<Camera::Setting> CameraImpl::current_settings() const {
-    return _settings;
+    std::vector<Camera::Setting> current_settings;
+    std::lock_guard<std::mutex> lock(_settings_mutex);
+    for (const auto &info : settings::kSettings) {
+        if (_settings.contains(info.id)) {
+            current_settings.emplace_back(build_setting(info.id, _settings[info.id]));
+        }
+    }
+    return current_settings;
 }
 
 void CameraImpl::possible_setting_options_async(
     const Camera::PossibleSettingOptionsCallback &callback) {
-    // TODO :)
+    base::LogDebug() << "call possible_setting_options_async";
+    callback(possible_setting_options());
 }
 
 std::vector<Camera::SettingOptions> CameraImpl::possible_setting_options() const {
-    // TODO :)
-    return {};
+    std::vector<Camera::SettingOptions> setting_options;
+    std::lock_guard<std::mutex> lock(_settings_mutex);
+    for (const auto &info : settings::kSettings) {
+        if (!_settings.contains(info.id)) {
+            continue;
+        }
+        Camera::SettingOptions options;
+        options.setting_id = info.name;
+        options.setting_description = info.description;
+        options.is_range = false;
+        for (size_t i = 0; i < info.option_count; i++) {
+            Camera::Option option;
+            option.option_id = info.options[i].value;
+            option.option_description = info.options[i].description;
+            options.options.emplace_back(option);
+        }
+        setting_options.emplace_back(options);
+    }
+    return setting_options;
 }
 
 Camera::Result CameraImpl::set_setting(Camera::Setting setting) {
     base::LogDebug() << "call set " << setting.setting_id << " to value "
                      << setting.option.option_id;
+    SettingId id;
+    if (!settings::find_setting(setting.setting_id, id)) {
+        base::LogError() << "Not implement setting" << setting.setting_id;
+        return Camera::Result::Success;
+    }
     bool set_success = false;
-    //camera mode settings
-    if (setting.setting_id == kCameraModeName) {
-        mav_camera::Mode set_mode = mav_camera::Mode::Unknown;
-        if (setting.option.option_id == "0") {
-            set_mode = mav_camera::Mode::Photo;
-        } else {
-            set_mode = mav_camera::Mode::Video;
+    switch (id) {
+        case SettingId::CamMode: {  //camera mode settings
+            mav_camera::Mode set_mode = mav_camera::Mode::Unknown;
+            if (setting.option.option_id == "0") {
+                set_mode = mav_camera::Mode::Photo;
+            } else {
+                set_mode = mav_camera::Mode::Video;
+            }
+            auto result = _mav_camera->set_mode(set_mode);
+            set_success = result == mav_camera::Result::Success;
+            break;
         }
-        auto result = _mav_camera->set_mode(set_mode);
-        set_success = result == mav_camera::Result::Success;
-    } else if (setting.setting_id == kCameraDisplayModeName) {
-        set_success = set_camera_display_mode(setting.option.option_id);
-    } else if (setting.setting_id == kPhotoResolution) {
-        if (setting.option.option_id == "0") {
-            auto result = _mav_camera->set_snapshot_resolution(kSnapshotWidth, kSnapshotHeight);
+        case SettingId::CamDisMode:
+            set_success = set_camera_display_mode(setting.option.option_id);
+            break;
+        case SettingId::CamPhotoRes:
+            if (setting.option.option_id == "0") {
+                auto result =
+                    _mav_camera->set_snapshot_resolution(kSnapshotWidth, kSnapshotHeight);
+                set_success = result == mav_camera::Result::Success;
+            } else if (setting.option.option_id == "1") {
+                auto result =
+                    _mav_camera->set_snapshot_resolution(kSnapshotHalfWidth, kSnapshotHalfHeight);
+                set_success = result == mav_camera::Result::Success;
+            }
+            break;
+        case SettingId::CamWbmode:  // whitebalance mode
+            set_success = set_whitebalance_mode(setting.option.option_id);
+            break;
+        case SettingId::CamExpmode:
+            // exposure mode not set to camera implement
+            set_success = true;
+            break;
+        case SettingId::CamEv: {  // exposure value
+            auto result = _mav_camera->set_exposure_value(std::stof(setting.option.option_id));
             set_success = result == mav_camera::Result::Success;
-        } else if (setting.option.option_id == "1") {
-            auto result =
-                _mav_camera->set_snapshot_resolution(kSnapshotHalfWidth, kSnapshotHalfHeight);
+            break;
+        }
+        case SettingId::CamIso: {
+            auto result = _mav_camera->set_iso(std::stoi(setting.option.option_id));
             set_success = result == mav_camera::Result::Success;
+            break;
         }
-    } else if (setting.setting_id == kWhitebalanceModeName) {  // whitebalance mode
-        set_success = set_whitebalance_mode(setting.option.option_id);
-    } else if (setting.setting_id == kExposureMode) {
-        // exposure mode not set to camera implement
-        set_success = true;
-    } else if (setting.setting_id == kEVName) {  // exposure value
-        auto result = _mav_camera->set_exposure_value(std::stof(setting.option.option_id));
-        set_success = result == mav_camera::Result::Success;
-    } else if (setting.setting_id == kISOName) {
-        auto result = _mav_camera->set_iso(std::stoi(setting.option.option_id));
-        set_success = result == mav_camera::Result::Success;
-    } else if (setting.setting_id == kShutterSpeedName) {
-        auto result = _mav_camera->set_shutter_speed(setting.option.option_id);
-        set_success = result == mav_camera::Result::Success;
-    } else if (setting.setting_id == kVideoResolution) {
-        set_success = set_video_resolution(setting.option.option_id);
-    } else if (setting.setting_id == kMeteringModeName) {
-        set_success = set_metering_mode(setting.option.option_id);
-    } else if (setting.setting_id == kIrCamPalette) {
-        set_success = set_ir_palette(setting.option.option_id);
-    } else if (setting.setting_id == kIrCamFFC) {
-        set_success = set_ir_FFC(setting.option.option_id);
-    } else {
-        base::LogError() << "Not implement setting" << setting.setting_id;
-        set_success = false;
+        case SettingId::CamShutterspd: {
+            auto result = _mav_camera->set_shutter_speed(setting.option.option_id);
+            set_success = result == mav_camera::Result::Success;
+            break;
+        }
+        case SettingId::CamVidres:
+            set_success = set_video_resolution(setting.option.option_id);
+            break;
+        case SettingId::CamMeter:
+            set_success = set_metering_mode(setting.option.option_id);
+            break;
+        case SettingId::IrcamPalette:
+            set_success = set_ir_palette(setting.option.option_id);
+            break;
+        case SettingId::IrcamFfc:
+            set_success = set_ir_FFC(setting.option.option_id);
+            break;
+        default:
+            base::LogError() << "Not implement setting" << setting.setting_id;
+            set_success = false;
+            break;
     }
 
     if (set_success) {  // update current setting
-        for (auto &it : _settings) {
-            if (it.setting_id == setting.setting_id) {
-                it.option.option_id = setting.option.option_id;
-                it.option.option_description = setting.option.option_description;
-            }
+        std::lock_guard<std::mutex> lock(_settings_mutex);
+        _settings_changes++;
+        if (_settings.contains(id)) {
+            _settings[id] = setting.option.option_id;
         }
     }
     return Camera::Result::Success;
@@ -528,14 +648,15 @@ Camera::Result CameraImpl::set_setting(Camera::Setting setting) {
 
 std::pair<Camera::Result, Camera::Setting> CameraImpl::get_setting(Camera::Setting setting) {
     base::LogDebug() << "call get_setting " << setting.setting_id;
-    for (auto &it : _settings) {
-        if (it.setting_id == setting.setting_id) {
-            setting.option.option_id = it.option.option_id;
-            setting.option.option_description = it.option.option_description;
-            return {Camera::Result::Success, setting};
-        }
-    }
-    return {Camera::Result::WrongArgument, setting};
+    SettingId id;
+    std::lock_guard<std::mutex> lock(_settings_mutex);
+    if (!settings::find_setting(setting.setting_id, id) || !_settings.contains(id)) {
+        return {Camera::Result::WrongArgument, setting};
+    }
+    setting.option.option_id = _settings[id];
+    auto option = settings::find_option(id, setting.option.option_id);
+    setting.option.option_description = option != nullptr ? option->description : "";
+    return {Camera::Result::Success, setting};
 }
 
 Camera::Result CameraImpl::format_storage(int32_t storage_id) {
@@ -558,26 +679,19 @@ Camera::Result CameraImpl::reset_settings() {
     auto result = _mav_camera->reset_settings();
     if (result == mav_camera::Result::Success) {
         // reset settings value
-        for (auto &it : _settings) {
-            // default camera display mode is PIP
-            if (it.setting_id == kCameraDisplayModeName) {
-                it.option.option_id = "3";
-            } else if (it.setting_id == kWhitebalanceModeName) {
-                it.option.option_id = "0";
-            } else if (it.setting_id == kExposureMode) {
-                it.option.option_id = "0";
-            } else if (it.setting_id == kEVName) {
-                it.option.option_id = "0";
-            } else if (it.setting_id == kISOName) {
-                it.option.option_id = "125";
-            } else if (it.setting_id == kShutterSpeedName) {
-                it.option.option_id = "0.01";
-            } else if (it.setting_id == kVideoFormat) {
-                it.option.option_id = "1";
-            } else if (it.setting_id == kMeteringModeName) {
-                it.option.option_id = "0";
-            } else if (it.setting_id == kCameraModeName) {
-                it.option.option_id = "0";
+        std::lock_guard<std::mutex> lock(_settings_mutex);
+        _settings_changes++;
+        // default camera display mode is PIP
+        const std::pair<SettingId, const char *> default_values[] = {
+            {SettingId::CamDisMode, "3"},    {SettingId::CamWbmode, "0"},
+            {SettingId::CamExpmode, "0"},    {SettingId::CamEv, "0"},
+            {SettingId::CamIso, "125"},      {SettingId::CamShutterspd, "0.01"},
+            {SettingId::CamVidfmt, "1"},     {SettingId::CamMeter, "0"},
+            {SettingId::CamMode, "0"},
+        };
+        for (const auto &[id, value] : default_values) {
+            if (_settings.contains(id)) {
+                _settings[id] = value;
             }
         }
     }
@@ -602,6 +716,12 @@ Camera::Result CameraImpl::set_zoom_range(float range) const {
 }
 
 void CameraImpl::deinit() {
+    _interval_scheduler.stop();
+    if (_verify_thread != nullptr) {
+        _verify_thread->join();
+        delete _verify_thread;
+        _verify_thread = nullptr;
+    }
     if (_mav_camera != nullptr) {
         _mav_camera->close();
         delete _mav_camera;
@@ -615,9 +735,12 @@ void CameraImpl::deinit() {
     free_ir_camera();
 }
 
-Camera::Setting CameraImpl::build_setting(std::string name, std::string value) {
+Camera::Setting CameraImpl::build_setting(SettingId id, std::string value) {
     Camera::Setting setting;
-    setting.setting_id = name;
+    setting.setting_id = settings::setting_name(id);
+    setting.setting_description = settings::setting_info(id).description;
+    auto option = settings::find_option(id, value);
+    setting.option.option_description = option != nullptr ? option->description : "";
     setting.option.option_id = value;
     return setting;
 }
@@ -889,6 +1012,8 @@ bool CameraImpl::init_ir_camera() {
         uint32_t minor = (version >> 16) & 0xFF;
         uint32_t patch = version & 0xFFFF;
         base::LogInfo() << "TYPE_CAMERA_VERSION: " << major << "." << minor << "." << patch;
+        _ir_version = std::to_string(major) + "." + std::to_string(minor) + "." +
+                      std::to_string(patch);
     } else {
         base::LogError() << "Failed to TYPE_CAMERA_VERSION.";
     }
@@ -953,6 +1078,90 @@ bool CameraImpl::set_ir_FFC(std::string /*ignore*/) {
     return false;
 }
 
+void CameraImpl::read_rgb_version() {
+    _rgb_version.clear();
+    mav_camera::Information info;
+    if (_mav_camera->get_information(info) != mav_camera::Result::Success) {
+        base::LogWarn() << "Cannot read qcom camera information";
+        return;
+    }
+    // the vendor interface reports no firmware version, its library is replaced with the firmware
+    struct link_map *library = nullptr;
+    struct stat library_stat;
+    if (dlinfo(_plugin_handle, RTLD_DI_LINKMAP, &library) != 0 || library == nullptr ||
+        stat(library->l_name, &library_stat) != 0) {
+        base::LogWarn() << "Cannot read version of " << QCOM_CAMERA_LIBERAY;
+        return;
+    }
+    _rgb_version = "sensor-" + std::to_string(info.horizontal_resolution_px) + "x" +
+                   std::to_string(info.vertical_resolution_px) + "-lens" +
+                   std::to_string(info.lens_id) + "/lib-" + std::to_string(library_stat.st_size) +
+                   "-" + std::to_string(library_stat.st_mtime);
+    base::LogInfo() << "RGB camera version: " << _rgb_version;
+}
+
+std::string CameraImpl::settings_identity() const {
+    return std::string(kModelName) + "/" + (_rgb_version.empty() ? "unknown" : _rgb_version) +
+           "/ir-" + (_ir_version.empty() ? "none" : _ir_version);
+}
+
+void CameraImpl::read_hardware_settings(settings::SettingValues &values) {
+    if (_ir_camera != nullptr) {
+        values[SettingId::IrcamPalette] = std::to_string(get_ir_palette());
+    }
+    values[SettingId::CamDisMode] = get_camera_display_mode();
+    values[SettingId::CamWbmode] = get_whitebalance_mode();
+    values[SettingId::CamEv] = get_ev_value();
+    values[SettingId::CamIso] = get_iso_value();
+    values[SettingId::CamShutterspd] = get_shutter_speed_value();
+    values[SettingId::CamVidres] = get_video_resolution();
+}
+
+void CameraImpl::save_settings_snapshot(const settings::SettingValues &values) {
+    if (_rgb_version.empty()) {
+        // could not be matched on next start
+        return;
+    }
+    SettingsSnapshot snapshot;
+    snapshot.identity = settings_identity();
+    for (const auto &info : settings::kSettings) {
+        if (values.contains(info.id)) {
+            snapshot.values[info.name] = values[info.id];
+        }
+    }
+    snapshot.values[kSnapshotWidthKey] = std::to_string(kSnapshotWidth);
+    snapshot.values[kSnapshotHeightKey] = std::to_string(kSnapshotHeight);
+    if (!snapshot.save(kSettingsSnapshotPath)) {
+        base::LogWarn() << "Cannot save settings snapshot";
+    }
+}
+
+void CameraImpl::verify_settings_thread(CameraImpl *self) {
+    uint32_t changes = 0;
+    {
+        std::lock_guard<std::mutex> lock(self->_settings_mutex);
+        changes = self->_settings_changes;
+    }
+    settings::SettingValues values;
+    self->read_hardware_settings(values);
+
+    std::lock_guard<std::mutex> lock(self->_settings_mutex);
+    if (changes != self->_settings_changes) {
+        // values read while a setting changed may be stale, verify again on next start
+        base::LogDebug() << "Settings changed during verification, keep snapshot";
+        return;
+    }
+    for (const auto &info : settings::kSettings) {
+        if (values.contains(info.id) && self->_settings.contains(info.id) &&
+            values[info.id] != self->_settings[info.id]) {
+            base::LogWarn() << "Setting " << info.name << " is " << values[info.id]
+                            << " instead of " << self->_settings[info.id] << " from snapshot";
+            self->_settings[info.id] = values[info.id];
+        }
+    }
+    self->save_settings_snapshot(values);
+}
+
 void CameraImpl::stop_video_async() {
     _mav_camera->stop_video();
 }
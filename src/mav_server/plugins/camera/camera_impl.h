@@ -3,12 +3,16 @@
 #include <atomic>
 #include <chrono>
 #include <mutex>
+#include <string>
 #include <thread>
 #include <vector>
 
+#include "base/interval_scheduler.h"
+#include "camera_settings.h"
 #include "libirextension.h"
 #include "mav_camera.h"
 #include "plugins/camera/camera.h"
+#include "plugins/camera/settings_snapshot.h"
 
 namespace mavcam {
 
@@ -272,7 +276,7 @@ private:
     /**
      * @brief build setting with name and value
      */
-    mavcam::Camera::Setting build_setting(std::string name, std::string value);
+    static mavcam::Camera::Setting build_setting(settings::SettingId id, std::string value);
     /**
      * @brief set camera display mode
      */
@@ -333,6 +337,26 @@ private:
      * @brief execute ir camera FFC
      */
     bool set_ir_FFC(std::string ignore);
+    /**
+     * @brief model and firmware versions a settings snapshot is valid for
+     */
+    std::string settings_identity() const;
+    /**
+     * @brief read the version of the prepared qcom camera into _rgb_version
+     */
+    void read_rgb_version();
+    /**
+     * @brief query every setting value the snapshot caches from camera hardware
+     */
+    void read_hardware_settings(settings::SettingValues &values);
+    /**
+     * @brief store values with snapshot resolution for next start
+     */
+    void save_settings_snapshot(const settings::SettingValues &values);
+    /**
+     * @brief compare published settings of a warm start with camera hardware
+     */
+    static void verify_settings_thread(CameraImpl *self);
 private:
     /**
      * @brief stop video async
@@ -347,10 +371,14 @@ private:
     Camera::CaptureInfoCallback _capture_info_callback;
     mutable Camera::Status _status;
     Camera::StatusCallback _status_callback;
+    base::IntervalScheduler _interval_scheduler;  ///< takes the photos of a photo interval
 private:
     mutable Camera::Mode _current_mode{Camera::Mode::Unknown};
     mutable std::chrono::steady_clock::time_point _start_video_time;
-    mutable std::vector<Camera::Setting> _settings;
+    settings::SettingValues _settings;
+    mutable std::mutex _settings_mutex;
+    uint32_t _settings_changes{0};  ///< count of set or reset, guarded by _settings_mutex
+    std::thread *_verify_thread{nullptr};
     mutable std::mutex _storage_information_mutex;
     mutable mav_camera::StorageInformation _current_storage_information;
     int32_t _framerate;
@@ -360,6 +388,8 @@ private:
 private:
     void *_ir_camera_handle{NULL};
     struct ir_extension_api *_ir_camera{nullptr};
+    std::string _ir_version{};
+    std::string _rgb_version{};  ///< empty when unknown
 };
 
 }  // namespace mavcam
\ No newline at end of file
@@ -10,12 +10,17 @@
 #include <sstream>
 #include <vector>
 
+#include "base/heartbeat.h"
 #include "base/log.h"
 #include "camera/camera.grpc.pb.h"
 #include "plugins/camera/camera.h"
 
 namespace mavcam {
 
+// unary handlers run on the grpc thread pool, each pool thread gets its own slot. Subscribe
+// handlers wait for their stream to close and are not watched.
+static constexpr const char *kHandlerHeartbeat = "rpc_handler";
+
 class CameraServiceImpl final : public mavcam::rpc::camera::CameraService::Service {
 public:
     CameraServiceImpl(std::shared_ptr<Camera> plugin) : _plugin(plugin) {}
@@ -799,6 +804,7 @@ public:
     grpc::Status Prepare(grpc::ServerContext * /* context */,
                          const mavcam::rpc::camera::PrepareRequest * /* request */,
                          mavcam::rpc::camera::PrepareResponse *response) override {
+        base::HeartbeatScope heartbeat(kHandlerHeartbeat);
         auto result = _plugin->prepare();
 
         if (response != nullptr) {
@@ -811,6 +817,7 @@ public:
     grpc::Status TakePhoto(grpc::ServerContext * /* context */,
                            const mavcam::rpc::camera::TakePhotoRequest * /* request */,
                            mavcam::rpc::camera::TakePhotoResponse *response) override {
+        base::HeartbeatScope heartbeat(kHandlerHeartbeat);
         auto result = _plugin->take_photo();
 
         if (response != nullptr) {
@@ -824,6 +831,7 @@ public:
         grpc::ServerContext * /* context */,
         const mavcam::rpc::camera::StartPhotoIntervalRequest *request,
         mavcam::rpc::camera::StartPhotoIntervalResponse *response) override {
+        base::HeartbeatScope heartbeat(kHandlerHeartbeat);
         if (request == nullptr) {
             base::LogWarn() << "StartPhotoInterval sent with a null request! Ignoring...";
             return grpc::Status::OK;
@@ -842,6 +850,7 @@ public:
         grpc::ServerContext * /* context */,
         const mavcam::rpc::camera::StopPhotoIntervalRequest * /* request */,
         mavcam::rpc::camera::StopPhotoIntervalResponse *response) override {
+        base::HeartbeatScope heartbeat(kHandlerHeartbeat);
         auto result = _plugin->stop_photo_interval();
 
         if (response != nullptr) {
@@ -854,6 +863,7 @@ public:
     grpc::Status StartVideo(grpc::ServerContext * /* context */,
                             const mavcam::rpc::camera::StartVideoRequest * /* request */,
                             mavcam::rpc::camera::StartVideoResponse *response) override {
+        base::HeartbeatScope heartbeat(kHandlerHeartbeat);
         auto result = _plugin->start_video();
 
         if (response != nullptr) {
@@ -866,6 +876,7 @@ public:
     grpc::Status StopVideo(grpc::ServerContext * /* context */,
                            const mavcam::rpc::camera::StopVideoRequest * /* request */,
                            mavcam::rpc::camera::StopVideoResponse *response) override {
+        base::HeartbeatScope heartbeat(kHandlerHeartbeat);
         auto result = _plugin->stop_video();
 
         if (response != nullptr) {
@@ -879,6 +890,7 @@ public:
         grpc::ServerContext * /* context */,
         const mavcam::rpc::camera::StartVideoStreamingRequest *request,
         mavcam::rpc::camera::StartVideoStreamingResponse *response) override {
+        base::HeartbeatScope heartbeat(kHandlerHeartbeat);
         if (request == nullptr) {
             base::LogWarn() << "StartVideoStreaming sent with a null request! Ignoring...";
             return grpc::Status::OK;
@@ -897,6 +909,7 @@ public:
         grpc::ServerContext * /* context */,
         const mavcam::rpc::camera::StopVideoStreamingRequest *request,
         mavcam::rpc::camera::StopVideoStreamingResponse *response) override {
+        base::HeartbeatScope heartbeat(kHandlerHeartbeat);
         if (request == nullptr) {
             base::LogWarn() << "StopVideoStreaming sent with a null request! Ignoring...";
             return grpc::Status::OK;
@@ -914,6 +927,7 @@ public:
     grpc::Status SetMode(grpc::ServerContext * /* context */,
                          const mavcam::rpc::camera::SetModeRequest *request,
                          mavcam::rpc::camera::SetModeResponse *response) override {
+        base::HeartbeatScope heartbeat(kHandlerHeartbeat);
         if (request == nullptr) {
             base::LogWarn() << "SetMode sent with a null request! Ignoring...";
             return grpc::Status::OK;
@@ -931,6 +945,7 @@ public:
     grpc::Status ListPhotos(grpc::ServerContext * /* context */,
                             const mavcam::rpc::camera::ListPhotosRequest *request,
                             mavcam::rpc::camera::ListPhotosResponse *response) override {
+        base::HeartbeatScope heartbeat(kHandlerHeartbeat);
         if (request == nullptr) {
             base::LogWarn() << "ListPhotos sent with a null request! Ignoring...";
             return grpc::Status::OK;
@@ -1135,6 +1150,7 @@ public:
     grpc::Status SetSetting(grpc::ServerContext * /* context */,
                             const mavcam::rpc::camera::SetSettingRequest *request,
                             mavcam::rpc::camera::SetSettingResponse *response) override {
+        base::HeartbeatScope heartbeat(kHandlerHeartbeat);
         if (request == nullptr) {
             base::LogWarn() << "SetSetting sent with a null request! Ignoring...";
             return grpc::Status::OK;
@@ -1152,6 +1168,7 @@ public:
     grpc::Status GetSetting(grpc::ServerContext * /* context */,
                             const mavcam::rpc::camera::GetSettingRequest *request,
                             mavcam::rpc::camera::GetSettingResponse *response) override {
+        base::HeartbeatScope heartbeat(kHandlerHeartbeat);
         if (request == nullptr) {
             base::LogWarn() << "GetSetting sent with a null request! Ignoring...";
             return grpc::Status::OK;
@@ -1171,6 +1188,7 @@ public:
     grpc::Status FormatStorage(grpc::ServerContext * /* context */,
                                const mavcam::rpc::camera::FormatStorageRequest *request,
                                mavcam::rpc::camera::FormatStorageResponse *response) override {
+        base::HeartbeatScope heartbeat(kHandlerHeartbeat);
         if (request == nullptr) {
             base::LogWarn() << "FormatStorage sent with a null request! Ignoring...";
             return grpc::Status::OK;
@@ -1188,6 +1206,7 @@ public:
     grpc::Status SelectCamera(grpc::ServerContext * /* context */,
                               const mavcam::rpc::camera::SelectCameraRequest *request,
                               mavcam::rpc::camera::SelectCameraResponse *response) override {
+        base::HeartbeatScope heartbeat(kHandlerHeartbeat);
         if (request == nullptr) {
             base::LogWarn() << "SelectCamera sent with a null request! Ignoring...";
             return grpc::Status::OK;
@@ -1205,6 +1224,7 @@ public:
     grpc::Status ResetSettings(grpc::ServerContext * /* context */,
                                const mavcam::rpc::camera::ResetSettingsRequest * /* request */,
                                mavcam::rpc::camera::ResetSettingsResponse *response) override {
+        base::HeartbeatScope heartbeat(kHandlerHeartbeat);
         auto result = _plugin->reset_settings();
 
         if (response != nullptr) {
@@ -1217,6 +1237,7 @@ public:
     grpc::Status SetTimestamp(grpc::ServerContext * /* context */,
                               const mavcam::rpc::camera::SetTimestampRequest *request,
                               mavcam::rpc::camera::SetTimestampResponse *response) override {
+        base::HeartbeatScope heartbeat(kHandlerHeartbeat);
         if (request == nullptr) {
             base::LogWarn() << "SetTimestamp sent with a null request! Ignoring...";
             return grpc::Status::OK;
@@ -1234,6 +1255,7 @@ public:
     grpc::Status SetZoomRange(grpc::ServerContext * /* context */,
                               const mavcam::rpc::camera::SetZoomRangeRequest *request,
                               mavcam::rpc::camera::SetZoomRangeResponse *response) override {
+        base::HeartbeatScope heartbeat(kHandlerHeartbeat);
         if (request == nullptr) {
             base::LogWarn() << "SetZoomRange sent with a null request! Ignoring...";
             return grpc::Status::OK;
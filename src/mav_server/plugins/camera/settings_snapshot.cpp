@@ -0,0 +1,75 @@
+#include "settings_snapshot.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#include "base/file_operation.h"
+#include "base/log.h"
+
+namespace mavcam {
+
+static const char *kSnapshotVersion = "1";
+static const std::string kVersionKey = "version";
+static const std::string kIdentityKey = "identity";
+
+bool SettingsSnapshot::load(const std::string &path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::string version;
+    identity.clear();
+    values.clear();
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t pos = line.find('=');
+        if (pos == std::string::npos) {
+            continue;
+        }
+        std::string key = line.substr(0, pos);
+        std::string value = line.substr(pos + 1);
+        if (key == kVersionKey) {
+            version = value;
+        } else if (key == kIdentityKey) {
+            identity = value;
+        } else {
+            values[key] = value;
+        }
+    }
+    if (version != kSnapshotVersion || identity.empty()) {
+        base::LogWarn() << "Ignore settings snapshot " << path << " of version " << version;
+        identity.clear();
+        values.clear();
+        return false;
+    }
+    return true;
+}
+
+bool SettingsSnapshot::save(const std::string &path) const {
+    std::ostringstream content;
+    content << kVersionKey << "=" << kSnapshotVersion << "\n";
+    content << kIdentityKey << "=" << identity << "\n";
+    for (const auto &[key, value] : values) {
+        content << key << "=" << value << "\n";
+    }
+    return base::write_file_atomic(path, content.str());
+}
+
+bool SettingsSnapshot::get_int(const std::string &key, int32_t &value) const {
+    auto it = values.find(key);
+    if (it == values.end() || it->second.empty()) {
+        return false;
+    }
+    char *end = nullptr;
+    errno = 0;
+    long result = strtol(it->second.c_str(), &end, 10);
+    if (errno != 0 || *end != '\0' || result < INT32_MIN || result > INT32_MAX) {
+        return false;
+    }
+    value = static_cast<int32_t>(result);
+    return true;
+}
+
+}  // namespace mavcam
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+namespace mavcam {
+
+/**
+ * @brief Setting values read from camera hardware on a previous start
+ * @details stored as "key=value" lines, the identity names the camera model and firmware
+ * versions the values were read from, a snapshot of another identity must not be used
+ */
+struct SettingsSnapshot final {
+    std::string identity{};
+    std::map<std::string, std::string> values{};
+
+    bool load(const std::string &path);
+    bool save(const std::string &path) const;
+    bool get_int(const std::string &key, int32_t &value) const;
+};
+
+}  // namespace mavcam
@@ -1,43 +1,81 @@
-#include <chrono>
+#include <algorithm>
 #include <cstdlib>
 #include <iostream>
-#include <thread>
+#include <string>
 
-#include "led_control/led_control.h"
+#include "process_supervisor.h"
 
-void notify(const std::string &message) {
-    // Use system notification (Linux 'notify-send')
-    std::string command = "notify-send 'mav_client Alert' '" + message + "'";
-    std::system(command.c_str());
-    std::cout << message << std::endl;
+static void usage(const char *bin_name) {
+    std::cout << "Usage : " << bin_name << " [Options] [program [args...]]" << std::endl
+              << "Keep program running, default program is mav_client" << std::endl
+              << "Options:" << std::endl
+              << "\t-h | --help     : show this help" << std::endl
+              << "\t--name         : process name to adopt, default is the program name"
+              << std::endl
+              << "\t--max_backoff_s: longest delay between restarts, default is 60" << std::endl
+              << "\t--stall_s      : busy thread without progress is a stall, default is 10, 0 "
+                 "disables"
+              << std::endl
+              << "\t--restart_on_stall : abort and restart the process on a stall" << std::endl;
 }
 
-bool isProcessRunning(const std::string &processName) {
-    std::string command = "pgrep -x " + processName + " > /dev/null 2>&1";
-    int ret = std::system(command.c_str());
-
-    if (ret == -1) {
-        std::cerr << "Failed to execute system command." << std::endl;
-        return false;  // Treat as not running if command execution fails
-    }
-
-    return (ret == 0);
-}
-
-int main() {
-    const std::string processName = "mav_client";
-    const int checkInterval = 5;  // in seconds
-
-    std::cout << "Monitoring process: " << processName << std::endl;
-
-    while (true) {
-        if (!isProcessRunning(processName)) {
-            notify("mav_client process has died!");
-            mavcam::switch_led_mode(mavcam::LedMode::Dead);
-            continue;
+int main(int argc, const char *argv[]) {
+    mavcam::ProcessSupervisor::Options options;
+    int i = 1;
+    for (; i < argc; i++) {
+        const std::string current_arg = argv[i];
+        if (current_arg == "-h" || current_arg == "--help") {
+            usage(argv[0]);
+            return 0;
+        } else if (current_arg == "--name") {
+            if (argc <= i + 1) {
+                usage(argv[0]);
+                return 1;
+            }
+            options.name = argv[++i];
+        } else if (current_arg == "--max_backoff_s") {
+            if (argc <= i + 1) {
+                usage(argv[0]);
+                return 1;
+            }
+            int max_backoff = std::atoi(argv[++i]);
+            if (max_backoff <= 0) {
+                usage(argv[0]);
+                return 1;
+            }
+            options.max_backoff = std::chrono::seconds(max_backoff);
+        } else if (current_arg == "--stall_s") {
+            if (argc <= i + 1) {
+                usage(argv[0]);
+                return 1;
+            }
+            int stall = std::atoi(argv[++i]);
+            if (stall < 0) {
+                usage(argv[0]);
+                return 1;
+            }
+            options.stall_time = std::chrono::seconds(stall);
+        } else if (current_arg == "--restart_on_stall") {
+            options.restart_on_stall = true;
+        } else if (current_arg == "--") {
+            i++;
+            break;
+        } else if (current_arg.rfind("-", 0) == 0) {
+            std::cout << "Invalid option : " << current_arg << std::endl;
+            usage(argv[0]);
+            return 1;
+        } else {
+            break;
         }
-        std::this_thread::sleep_for(std::chrono::seconds(checkInterval));
     }
+    for (; i < argc; i++) {
+        options.command.push_back(argv[i]);
+    }
+    if (options.command.empty()) {
+        options.command.push_back("mav_client");
+    }
+    options.min_backoff = std::min(options.min_backoff, options.max_backoff);
 
-    return 0;
+    mavcam::ProcessSupervisor supervisor(options);
+    return supervisor.run() ? 0 : 1;
 }
@@ -0,0 +1,321 @@
+#include "process_supervisor.h"
+
+#include <dirent.h>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/signalfd.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+#include "base/log.h"
+#include "led_control/led_control.h"
+
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
+
+extern char **environ;
+
+namespace mavcam {
+
+// a launched process gets this long to quit on SIGTERM before it is killed
+static constexpr auto kStopTimeout = std::chrono::seconds(5);
+// only used when the kernel has no pidfd_open
+static constexpr auto kFallbackPollInterval = std::chrono::seconds(1);
+
+static int pidfd_open(pid_t pid) {
+    return static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+}
+
+/**
+ * @brief spawn a program found in PATH with the signal mask the supervisor started with
+ */
+static pid_t spawn(const std::vector<std::string> &command, const sigset_t &mask) {
+    std::vector<char *> argv;
+    for (const auto &arg : command) {
+        argv.push_back(const_cast<char *>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK);
+    posix_spawnattr_setsigmask(&attr, &mask);
+    pid_t pid = -1;
+    int ret = posix_spawnp(&pid, argv[0], nullptr, &attr, argv.data(), environ);
+    posix_spawnattr_destroy(&attr);
+    if (ret != 0) {
+        base::LogError() << "Cannot launch " << command[0] << ": " << strerror(ret);
+        return -1;
+    }
+    return pid;
+}
+
+ProcessSupervisor::ProcessSupervisor(Options options) : _options(std::move(options)) {
+    if (_options.name.empty() && !_options.command.empty()) {
+        const std::string &program = _options.command[0];
+        _options.name = program.substr(program.rfind('/') + 1);
+    }
+}
+
+ProcessSupervisor::~ProcessSupervisor() {
+    if (_signal_fd >= 0) {
+        close(_signal_fd);
+        sigprocmask(SIG_SETMASK, &_old_mask, nullptr);
+    }
+}
+
+bool ProcessSupervisor::run() {
+    if (_options.command.empty()) {
+        base::LogError() << "No command to supervise";
+        return false;
+    }
+    // stop signals are read from a signalfd, so they can be polled together with the pidfd
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    if (sigprocmask(SIG_BLOCK, &mask, &_old_mask) != 0) {
+        base::LogError() << "Cannot block stop signals: " << strerror(errno);
+        return false;
+    }
+    _signal_fd = signalfd(-1, &mask, SFD_CLOEXEC);
+    if (_signal_fd < 0) {
+        base::LogError() << "Cannot create signalfd: " << strerror(errno);
+        sigprocmask(SIG_SETMASK, &_old_mask, nullptr);
+        return false;
+    }
+
+    auto backoff = _options.min_backoff;
+    bool child = false;
+    pid_t pid = find_process();
+    if (pid > 0) {
+        base::LogInfo() << "Adopt running " << _options.name << " with pid " << pid;
+    }
+    while (true) {
+        if (pid <= 0) {
+            pid = launch();
+            child = true;
+        }
+        auto start = std::chrono::steady_clock::now();
+        if (pid > 0) {
+            int status = 0;
+            auto result = wait_exit(pid, child, status);
+            if (result == WaitResult::Stopped) {
+                if (child) {
+                    stop_child(pid);
+                }
+                break;
+            }
+            report_exit(pid, result, status, std::chrono::steady_clock::now() - start);
+        }
+
+        if (std::chrono::steady_clock::now() - start >= _options.stable_time) {
+            backoff = _options.min_backoff;
+        }
+        base::LogInfo() << "Restart " << _options.name << " in " << backoff.count() << " s";
+        if (wait_stop_signal(backoff)) {
+            break;
+        }
+        backoff = std::min(backoff * 2, _options.max_backoff);
+        pid = -1;
+    }
+    base::LogInfo() << "Stop supervising " << _options.name;
+    return true;
+}
+
+pid_t ProcessSupervisor::find_process() const {
+    // comm holds at most 15 characters of the name
+    std::string comm_name = _options.name.substr(0, 15);
+    DIR *proc = opendir("/proc");
+    if (proc == nullptr) {
+        return -1;
+    }
+    pid_t found = -1;
+    while (struct dirent *entry = readdir(proc)) {
+        char *end = nullptr;
+        long pid = strtol(entry->d_name, &end, 10);
+        if (*end != '\0' || pid <= 0 || pid == getpid()) {
+            continue;
+        }
+        std::ifstream comm_file(std::string("/proc/") + entry->d_name + "/comm");
+        std::string comm;
+        if (std::getline(comm_file, comm) && comm == comm_name) {
+            found = static_cast<pid_t>(pid);
+            break;
+        }
+    }
+    closedir(proc);
+    return found;
+}
+
+pid_t ProcessSupervisor::launch() {
+    pid_t pid = spawn(_options.command, _old_mask);
+    if (pid > 0) {
+        base::LogInfo() << "Launch " << _options.command[0] << " with pid " << pid;
+    }
+    return pid;
+}
+
+ProcessSupervisor::WaitResult ProcessSupervisor::wait_exit(pid_t pid, bool child, int &status) {
+    _heartbeat.close();
+    _aborting = false;
+    int timeout_ms = _options.stall_time.count() > 0 ? _options.heartbeat_interval.count() : -1;
+    int pid_fd = pidfd_open(pid);
+    if (pid_fd >= 0) {
+        struct pollfd fds[2] = {{pid_fd, POLLIN, 0}, {_signal_fd, POLLIN, 0}};
+        while (true) {
+            int ret = poll(fds, 2, timeout_ms);
+            if (ret > 0 || (ret < 0 && errno != EINTR)) {
+                break;
+            }
+            check_heartbeat(pid);
+        }
+        close(pid_fd);
+        if (fds[1].revents & POLLIN) {
+            read_stop_signal();
+            return WaitResult::Stopped;
+        }
+    } else {
+        base::LogWarn() << "pidfd_open failed: " << strerror(errno) << ", poll process state";
+        while (true) {
+            if (child ? waitpid(pid, &status, WNOHANG) == pid : kill(pid, 0) != 0) {
+                return child ? WaitResult::Exited : WaitResult::Vanished;
+            }
+            if (wait_stop_signal(kFallbackPollInterval)) {
+                return WaitResult::Stopped;
+            }
+            check_heartbeat(pid);
+        }
+    }
+    // only the parent can read the exit status, it is lost for an adopted process
+    if (!child) {
+        return WaitResult::Vanished;
+    }
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+    }
+    return WaitResult::Exited;
+}
+
+bool ProcessSupervisor::wait_stop_signal(std::chrono::milliseconds timeout) {
+    struct pollfd fd = {_signal_fd, POLLIN, 0};
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (true) {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now());
+        int ret = poll(&fd, 1, static_cast<int>(std::max<int64_t>(left.count(), 0)));
+        if (ret > 0) {
+            read_stop_signal();
+            return true;
+        }
+        if (ret == 0 || errno != EINTR) {
+            return false;
+        }
+    }
+}
+
+void ProcessSupervisor::read_stop_signal() {
+    // a signal left pending would kill the process once the mask is restored
+    struct signalfd_siginfo info;
+    if (read(_signal_fd, &info, sizeof(info)) == sizeof(info)) {
+        base::LogInfo() << "Received signal " << info.ssi_signo;
+    }
+}
+
+void ProcessSupervisor::check_heartbeat(pid_t pid) {
+    if (_options.stall_time.count() <= 0) {
+        return;
+    }
+    // the region shows up once the process opened it
+    if (!_heartbeat.is_open() && !_heartbeat.open(_options.name, pid)) {
+        return;
+    }
+    for (const auto &stall : _heartbeat.check(_options.stall_time)) {
+        auto seconds = std::chrono::duration_cast<std::chrono::seconds>(stall.duration).count();
+        std::string message = _options.name + " thread " + stall.name + " stalled for " +
+                              std::to_string(seconds) + " s";
+        base::LogError() << message;
+        notify(message);
+        if (_options.restart_on_stall && !_aborting) {
+            // abort dumps a core showing where the thread hangs
+            base::LogWarn() << "Abort " << _options.name << " with pid " << pid;
+            kill(pid, SIGABRT);
+            _aborting = true;
+            _abort_time = std::chrono::steady_clock::now();
+        }
+    }
+    if (_aborting && std::chrono::steady_clock::now() - _abort_time >= kStopTimeout) {
+        base::LogWarn() << _options.name << " ignored SIGABRT, kill it";
+        kill(pid, SIGKILL);
+        _aborting = false;
+    }
+}
+
+void ProcessSupervisor::stop_child(pid_t pid) {
+    base::LogInfo() << "Stop " << _options.name << " with pid " << pid;
+    kill(pid, SIGTERM);
+    auto deadline = std::chrono::steady_clock::now() + kStopTimeout;
+    int status = 0;
+    while (waitpid(pid, &status, WNOHANG) == 0) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            base::LogWarn() << _options.name << " ignored SIGTERM, kill it";
+            kill(pid, SIGKILL);
+            waitpid(pid, &status, 0);
+            return;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+}
+
+void ProcessSupervisor::report_exit(pid_t pid, WaitResult result, int status,
+                                    std::chrono::steady_clock::duration runtime) {
+    std::string message = _options.name + " (pid " + std::to_string(pid) + ") ";
+    if (result == WaitResult::Vanished) {
+        message += "exited, status unknown";
+    } else if (WIFEXITED(status)) {
+        message += "exited with code " + std::to_string(WEXITSTATUS(status));
+    } else if (WIFSIGNALED(status)) {
+        int signal = WTERMSIG(status);
+        message += "killed by signal " + std::to_string(signal) + " (" + strsignal(signal) + ")";
+        if (WCOREDUMP(status)) {
+            std::ifstream pattern_file("/proc/sys/kernel/core_pattern");
+            std::string core_pattern;
+            std::getline(pattern_file, core_pattern);
+            message += ", core dumped to " + core_pattern;
+        }
+    }
+    message += " after " +
+               std::to_string(std::chrono::duration_cast<std::chrono::seconds>(runtime).count()) +
+               " s";
+    base::LogError() << message;
+    switch_led_mode(LedMode::Dead);
+    notify(message);
+}
+
+void ProcessSupervisor::notify(const std::string &message) {
+    auto now = std::chrono::steady_clock::now();
+    if (_notified && now - _last_notify < _options.notify_interval) {
+        _suppressed_notifications++;
+        return;
+    }
+    std::string text = message;
+    if (_suppressed_notifications > 0) {
+        text += ", " + std::to_string(_suppressed_notifications) + " more since last alert";
+    }
+    _notified = true;
+    _last_notify = now;
+    _suppressed_notifications = 0;
+    pid_t pid = spawn({"notify-send", "mav_watch Alert", text}, _old_mask);
+    if (pid > 0) {
+        waitpid(pid, nullptr, 0);
+    }
+}
+
+}  // namespace mavcam
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <signal.h>
+#include <sys/types.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "base/heartbeat.h"
+
+namespace mavcam {
+
+/**
+ * @brief Keeps one process running and restarts it when it exits
+ * @details A running process with the same name is adopted, otherwise the command is launched.
+ * Exit is detected through a pidfd, so waiting costs nothing. Restarts back off exponentially
+ * and the backoff is reset once a run lasted stable_time. Exit status and core dumps are logged,
+ * desktop notifications are rate limited. While waiting, the heartbeat region of the process is
+ * sampled to find threads that hang, optionally the process is aborted and restarted then.
+ */
+class ProcessSupervisor final {
+public:
+    struct Options {
+        std::vector<std::string> command{};  ///< program and its arguments
+        std::string name{};                  ///< process name to adopt, program name if empty
+        std::chrono::seconds min_backoff{1};
+        std::chrono::seconds max_backoff{60};
+        std::chrono::seconds stable_time{60};  ///< a run this long resets the backoff
+        std::chrono::seconds notify_interval{60};
+        std::chrono::milliseconds heartbeat_interval{250};
+        std::chrono::seconds stall_time{10};  ///< busy thread without progress, 0 disables
+        bool restart_on_stall{false};
+    };
+public:
+    explicit ProcessSupervisor(Options options);
+    ~ProcessSupervisor();
+public:
+    /**
+     * @brief supervise until SIGINT or SIGTERM, a launched process is stopped as well
+     * @return false when the stop signals cannot be watched
+     */
+    bool run();
+private:
+    enum class WaitResult {
+        Exited,    ///< status holds the wait status
+        Vanished,  ///< adopted process exited, its status is unknown
+        Stopped,   ///< stop signal received
+    };
+private:
+    pid_t find_process() const;
+    pid_t launch();
+    WaitResult wait_exit(pid_t pid, bool child, int &status);
+    bool wait_stop_signal(std::chrono::milliseconds timeout);
+    void read_stop_signal();
+    void check_heartbeat(pid_t pid);
+    void stop_child(pid_t pid);
+    void report_exit(pid_t pid, WaitResult result, int status,
+                     std::chrono::steady_clock::duration runtime);
+    void notify(const std::string &message);
+private:
+    Options _options;
+    int _signal_fd{-1};
+    sigset_t _old_mask{};
+    bool _notified{false};
+    std::chrono::steady_clock::time_point _last_notify{};
+    uint32_t _suppressed_notifications{0};
+    base::HeartbeatReader _heartbeat{};
+    bool _aborting{false};  ///< SIGABRT sent for a stall
+    std::chrono::steady_clock::time_point _abort_time{};
+};
+
+}  // namespace mavcam
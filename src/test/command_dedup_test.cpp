@@ -0,0 +1,95 @@
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+
+#include "command_dedup.h"
+
+// feeds single photo commands the way a ground station repeats them after its ack timeout, the
+// ticks of an interval capture never reach the dedup, see MavClient::create_passthrough()
+
+static constexpr uint16_t kImageStartCapture = 2000;
+static constexpr uint16_t kGroundStation = (255 << 8) | 190;
+static constexpr uint16_t kOtherStation = (254 << 8) | 190;
+static constexpr auto kWindow = std::chrono::seconds(3);
+static constexpr auto kAckTimeout = std::chrono::milliseconds(700);
+
+static int failures = 0;
+
+static void expect(bool condition, const char *what) {
+    if (!condition) {
+        std::cout << "FAIL: " << what << std::endl;
+        failures++;
+    }
+}
+
+static mavcam::CommandDedup::State begin(mavcam::CommandDedup &dedup, uint16_t sender,
+                                         int32_t index) {
+    mavcam::CommandDedup::Replay replay;
+    return dedup.begin(sender, kImageStartCapture, index, replay);
+}
+
+static void retransmit_after_ack_timeout_is_suppressed() {
+    mavcam::CommandDedup dedup(kWindow, 16);
+    expect(begin(dedup, kGroundStation, 3) == mavcam::CommandDedup::State::New,
+           "first command is new");
+    std::this_thread::sleep_for(kAckTimeout);
+    expect(begin(dedup, kGroundStation, 3) == mavcam::CommandDedup::State::Running,
+           "retransmit while the photo runs is dropped");
+    int replays = 0;
+    dedup.finish(kGroundStation, kImageStartCapture, 3, [&replays]() { replays++; });
+    std::this_thread::sleep_for(kAckTimeout);
+    mavcam::CommandDedup::Replay replay;
+    expect(dedup.begin(kGroundStation, kImageStartCapture, 3, replay) ==
+               mavcam::CommandDedup::State::Done,
+           "retransmit after the answer is done");
+    if (replay) {
+        replay();
+    }
+    expect(replays == 1, "retransmit after the answer gets it again");
+    expect(begin(dedup, kGroundStation, 4) == mavcam::CommandDedup::State::New,
+           "next sequence is new");
+}
+
+static void other_sender_is_new() {
+    mavcam::CommandDedup dedup(kWindow, 16);
+    expect(begin(dedup, kGroundStation, 3) == mavcam::CommandDedup::State::New,
+           "first command is new");
+    expect(begin(dedup, kOtherStation, 3) == mavcam::CommandDedup::State::New,
+           "same sequence of another ground station is new");
+}
+
+static void first_transmission_without_sequence_is_new() {
+    mavcam::CommandDedup dedup(kWindow, 16);
+    expect(begin(dedup, kGroundStation, 0) == mavcam::CommandDedup::State::New,
+           "first photo without sequence is new");
+    dedup.finish(kGroundStation, kImageStartCapture, 0, nullptr);
+    // a first transmission, confirmation 0, is forgotten before it begins
+    dedup.forget(kGroundStation, kImageStartCapture, 0);
+    expect(begin(dedup, kGroundStation, 0) == mavcam::CommandDedup::State::New,
+           "next photo without sequence is new");
+    std::this_thread::sleep_for(kAckTimeout);
+    expect(begin(dedup, kGroundStation, 0) == mavcam::CommandDedup::State::Running,
+           "confirmation of a photo without sequence is dropped");
+}
+
+static void expired_command_runs_again() {
+    mavcam::CommandDedup dedup(std::chrono::milliseconds(100), 16);
+    expect(begin(dedup, kGroundStation, 5) == mavcam::CommandDedup::State::New,
+           "first command is new");
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    expect(begin(dedup, kGroundStation, 5) == mavcam::CommandDedup::State::New,
+           "command after the window is new");
+}
+
+int main() {
+    retransmit_after_ack_timeout_is_suppressed();
+    other_sender_is_new();
+    first_transmission_without_sequence_is_new();
+    expired_command_runs_again();
+    if (failures > 0) {
+        return 1;
+    }
+    std::cout << "PASS" << std::endl;
+    return 0;
+}
@@ -0,0 +1,279 @@
+#!/usr/bin/env python3
+"""Generate C++ setting tables from a MAVLink camera definition file.
+
+Usage: generate_camera_settings.py <definition.xml> <output header>
+
+The header holds an enum of every parameter, typed option tables with value ranges and a
+constexpr name to id lookup, so camera clients dispatch settings without string compares.
+The <updates> and <exclusions> of the definition become setting masks, which tell what has to
+be read again after a setting changed.
+"""
+
+import os
+import re
+import sys
+import xml.etree.ElementTree as ET
+
+TYPES = {"int32": "Int32", "float": "Float"}
+MAX_SETTINGS = 64  # SettingMask is a uint64_t
+
+
+def camel_case(name):
+    return "".join(part.capitalize() for part in name.lower().split("_"))
+
+
+def c_string(value):
+    return '"' + value.replace("\\", "\\\\").replace('"', '\\"') + '"'
+
+
+def c_number(value):
+    text = repr(float(value))
+    return text if re.search(r"[.e]", text) else text + ".0"
+
+
+def parse_definition(path):
+    root = ET.parse(path).getroot()
+    definition = root.find("definition")
+    model = definition.findtext("model", "").strip()
+    version = int(definition.get("version", "0"))
+    settings = []
+    for parameter in root.iter("parameter"):
+        name = parameter.get("name")
+        type_name = parameter.get("type")
+        if type_name not in TYPES:
+            sys.exit("{}: parameter {} has unsupported type {}".format(path, name, type_name))
+        options = []
+        for option in parameter.iter("option"):
+            value = option.get("value")
+            try:
+                number = float(value)
+            except ValueError:
+                sys.exit("{}: option {} of {} is not a number".format(path, value, name))
+            options.append({
+                "value": value,
+                "name": option.get("name"),
+                "number": number,
+                "exclusions": [exclude.text.strip() for exclude in option.iter("exclude")],
+            })
+        if not options:
+            sys.exit("{}: parameter {} has no options".format(path, name))
+        settings.append({
+            "name": name,
+            "id": camel_case(name),
+            "description": parameter.findtext("description", "").strip(),
+            "type": TYPES[type_name],
+            "default": parameter.get("default", options[0]["value"]),
+            "options": options,
+            "updates": [update.text.strip() for update in parameter.iter("update")],
+        })
+    if len(settings) > MAX_SETTINGS:
+        sys.exit("{}: more than {} parameters".format(path, MAX_SETTINGS))
+    names = {setting["name"] for setting in settings}
+    for setting in settings:
+        references = list(setting["updates"])
+        for option in setting["options"]:
+            references += option["exclusions"]
+        for reference in references:
+            if reference not in names:
+                sys.exit("{}: {} refers to unknown parameter {}".format(path, setting["name"],
+                                                                       reference))
+    resolve_updates(settings)
+    return model, version, settings
+
+
+def resolve_updates(settings):
+    """Follow updates transitively, a setting updated by another one may update more."""
+    by_name = {setting["name"]: setting for setting in settings}
+    for setting in settings:
+        resolved = []
+        pending = list(setting["updates"])
+        while pending:
+            name = pending.pop(0)
+            if name == setting["name"] or name in resolved:
+                continue
+            resolved.append(name)
+            pending += by_name[name]["updates"]
+        setting["updates"] = resolved
+
+
+def c_mask(names, settings):
+    by_name = {setting["name"]: setting for setting in settings}
+    if not names:
+        return "0"
+    return " | ".join("setting_mask(SettingId::{})".format(by_name[name]["id"]) for name in names)
+
+
+def generate(definition_path, model, version, settings):
+    lines = []
+    out = lines.append
+    out("// Generated by tools/generate_camera_settings.py from {}, do not edit.".format(
+        os.path.basename(definition_path)))
+    out("#pragma once")
+    out("")
+    out("#include <array>")
+    out("#include <cstddef>")
+    out("#include <cstdint>")
+    out("#include <string>")
+    out("#include <string_view>")
+    out("")
+    out("namespace mavcam::settings {")
+    out("")
+    out("constexpr const char *kModelName = {};".format(c_string(model)))
+    out("constexpr int kDefinitionVersion = {};".format(version))
+    out("")
+    out("enum class SettingId : uint8_t {")
+    for index, setting in enumerate(settings):
+        out("    {} = {},  ///< {}".format(setting["id"], index, setting["name"]))
+    out("};")
+    out("")
+    out("constexpr size_t kSettingCount = {};".format(len(settings)))
+    out("")
+    out("/// one bit per SettingId")
+    out("using SettingMask = uint64_t;")
+    out("")
+    out("constexpr SettingMask setting_mask(SettingId id) {")
+    out("    return SettingMask{1} << static_cast<size_t>(id);")
+    out("}")
+    out("")
+    out("constexpr SettingMask kAllSettings = (SettingMask{1} << (kSettingCount - 1) << 1) - 1;")
+    out("")
+    out("enum class SettingType : uint8_t {")
+    for type_name in TYPES.values():
+        out("    {},".format(type_name))
+    out("};")
+    out("")
+    out("struct OptionInfo {")
+    out("    const char *value;        ///< option id sent over MAVLink")
+    out("    const char *description;  ///< option name shown to the user")
+    out("    double number;            ///< value as number")
+    out("    SettingMask exclusions;   ///< settings hidden while this option is selected")
+    out("};")
+    out("")
+    out("struct SettingInfo {")
+    out("    SettingId id;")
+    out("    const char *name;")
+    out("    const char *description;")
+    out("    SettingType type;")
+    out("    const char *default_value;")
+    out("    const OptionInfo *options;")
+    out("    size_t option_count;")
+    out("    double min;  ///< smallest option value")
+    out("    double max;  ///< largest option value")
+    out("    SettingMask updates;  ///< settings that may change with this one, transitively")
+    out("};")
+    out("")
+    out("namespace detail {")
+    out("")
+    for setting in settings:
+        out("inline constexpr OptionInfo k{}Options[] = {{".format(setting["id"]))
+        for option in setting["options"]:
+            out("    {{{}, {}, {},".format(c_string(option["value"]), c_string(option["name"]),
+                                         c_number(option["number"])))
+            out("     {}}},".format(c_mask(option["exclusions"], settings)))
+        out("};")
+        out("")
+    out("}  // namespace detail")
+    out("")
+    out("inline constexpr SettingInfo kSettings[kSettingCount] = {")
+    for setting in settings:
+        numbers = [option["number"] for option in setting["options"]]
+        out("    {{SettingId::{id}, {name}, {description}, SettingType::{type}, {default},".format(
+            id=setting["id"], name=c_string(setting["name"]),
+            description=c_string(setting["description"]), type=setting["type"],
+            default=c_string(setting["default"])))
+        out("     detail::k{id}Options, {count}, {min}, {max},".format(
+            id=setting["id"], count=len(setting["options"]), min=c_number(min(numbers)),
+            max=c_number(max(numbers))))
+        out("     {}}},".format(c_mask(setting["updates"], settings)))
+    out("};")
+    out("")
+    out("constexpr const SettingInfo &setting_info(SettingId id) {")
+    out("    return kSettings[static_cast<size_t>(id)];")
+    out("}")
+    out("")
+    out("constexpr const char *setting_name(SettingId id) {")
+    out("    return setting_info(id).name;")
+    out("}")
+    out("")
+    out("/**")
+    out(" * @brief look up a setting by name, compares only names of the same length")
+    out(" * @return false when name is not a parameter of the camera definition")
+    out(" */")
+    out("constexpr bool find_setting(std::string_view name, SettingId &id) {")
+    out("    switch (name.size()) {")
+    by_size = {}
+    for setting in settings:
+        by_size.setdefault(len(setting["name"]), []).append(setting)
+    for size in sorted(by_size):
+        out("        case {}:".format(size))
+        for setting in by_size[size]:
+            out("            if (name == {}) {{".format(c_string(setting["name"])))
+            out("                id = SettingId::{};".format(setting["id"]))
+            out("                return true;")
+            out("            }")
+        out("            return false;")
+    out("    }")
+    out("    return false;")
+    out("}")
+    out("")
+    out("/**")
+    out(" * @brief look up an option of a setting by its value")
+    out(" * @return nullptr when value is not an option of the setting")
+    out(" */")
+    out("constexpr const OptionInfo *find_option(SettingId id, std::string_view value) {")
+    out("    const SettingInfo &info = setting_info(id);")
+    out("    for (size_t i = 0; i < info.option_count; i++) {")
+    out("        if (value == info.options[i].value) {")
+    out("            return &info.options[i];")
+    out("        }")
+    out("    }")
+    out("    return nullptr;")
+    out("}")
+    out("")
+    out("/**")
+    out(" * @brief settings hidden while id has the given value")
+    out(" */")
+    out("constexpr SettingMask excluded_settings(SettingId id, std::string_view value) {")
+    out("    const OptionInfo *option = find_option(id, value);")
+    out("    return option != nullptr ? option->exclusions : 0;")
+    out("}")
+    out("")
+    out("/**")
+    out(" * @brief current value of every setting indexed by SettingId")
+    out(" * @details an empty value marks a setting the camera does not provide")
+    out(" */")
+    out("class SettingValues final {")
+    out("public:")
+    out("    std::string &operator[](SettingId id) { return _values[static_cast<size_t>(id)]; }")
+    out("    const std::string &operator[](SettingId id) const {")
+    out("        return _values[static_cast<size_t>(id)];")
+    out("    }")
+    out("    bool contains(SettingId id) const { return !(*this)[id].empty(); }")
+    out("private:")
+    out("    std::array<std::string, kSettingCount> _values{};")
+    out("};")
+    out("")
+    out("}  // namespace mavcam::settings")
+    return "\n".join(lines) + "\n"
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit(__doc__)
+    definition_path, output_path = sys.argv[1], sys.argv[2]
+    model, version, settings = parse_definition(definition_path)
+    content = generate(definition_path, model, version, settings)
+    output_dir = os.path.dirname(output_path)
+    if output_dir:
+        os.makedirs(output_dir, exist_ok=True)
+    # keep the timestamp when nothing changed, so dependents are not rebuilt
+    if os.path.exists(output_path):
+        with open(output_path) as output:
+            if output.read() == content:
+                return
+    with open(output_path, "w") as output:
+        output.write(content)
+
+
+if __name__ == "__main__":
+    main()